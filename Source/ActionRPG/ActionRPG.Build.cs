@@ -27,7 +27,8 @@ public class ActionRPG : ModuleRules
 				"GameplayAbilities",
 				"GameplayTags",
 				"GameplayTasks",
-				"AIModule"
+				"AIModule",
+				"NetCore"
 			}
 		);
 
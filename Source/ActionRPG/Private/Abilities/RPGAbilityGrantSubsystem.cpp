@@ -0,0 +1,171 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Abilities/RPGAbilityGrantSubsystem.h"
+#include "Abilities/RPGGameplayAbility.h"
+#include "RPGCharacterBase.h"
+#include "Engine/World.h"
+#include "Engine/GameInstance.h"
+#include "GameFramework/Controller.h"
+#include "HAL/IConsoleManager.h"
+
+static int32 GRPGUseGrantTemplates = 1;
+static FAutoConsoleVariableRef CVarRPGUseGrantTemplates(
+	TEXT("RPG.Abilities.UseGrantTemplates"),
+	GRPGUseGrantTemplates,
+	TEXT("If non zero, characters grant startup abilities and passive effects from a template shared by their class and level"));
+
+void URPGAbilityGrantSubsystem::Deinitialize()
+{
+	ResetTemplates();
+
+	Super::Deinitialize();
+}
+
+bool URPGAbilityGrantSubsystem::AreTemplatesEnabled()
+{
+	return GRPGUseGrantTemplates != 0;
+}
+
+TSharedRef<const FRPGAbilityGrantTemplate> URPGAbilityGrantSubsystem::FindOrCreateTemplate(const UClass* CharacterClass, int32 Level, const TArray<TSubclassOf<URPGGameplayAbility>>& Abilities, const TArray<TSubclassOf<UGameplayEffect>>& PassiveEffects)
+{
+	const TPair<TObjectKey<UClass>, int32> Key(CharacterClass, Level);
+
+	if (const TSharedRef<const FRPGAbilityGrantTemplate>* FoundTemplate = Templates.Find(Key))
+	{
+		return *FoundTemplate;
+	}
+
+	TSharedRef<FRPGAbilityGrantTemplate> NewTemplate = MakeShared<FRPGAbilityGrantTemplate>();
+	NewTemplate->Level = Level;
+
+	NewTemplate->Abilities.Reserve(Abilities.Num());
+	for (const TSubclassOf<URPGGameplayAbility>& Ability : Abilities)
+	{
+		if (Ability)
+		{
+			NewTemplate->Abilities.Add(Ability);
+		}
+	}
+
+	// Source data is captured per instance once a context is set, everything else only depends on the definition and level
+	NewTemplate->PassiveEffects.Reserve(PassiveEffects.Num());
+	for (const TSubclassOf<UGameplayEffect>& PassiveEffect : PassiveEffects)
+	{
+		if (PassiveEffect)
+		{
+			NewTemplate->PassiveEffects.Emplace(PassiveEffect->GetDefaultObject<UGameplayEffect>(), FGameplayEffectContextHandle(), Level);
+		}
+	}
+
+	UE_LOG(LogActionRPG, Verbose, TEXT("Built grant template for %s at level %d, %d abilities and %d passive effects"), *GetNameSafe(CharacterClass), Level, NewTemplate->Abilities.Num(), NewTemplate->PassiveEffects.Num());
+
+	Templates.Add(Key, NewTemplate);
+	return NewTemplate;
+}
+
+void URPGAbilityGrantSubsystem::ResetTemplates()
+{
+	Templates.Reset();
+}
+
+int32 URPGAbilityGrantSubsystem::GetNumTemplates() const
+{
+	return Templates.Num();
+}
+
+#if !UE_BUILD_SHIPPING
+
+/** Spawns a batch of characters in a grid around the world origin and returns the seconds spent spawning */
+static double SpawnBenchmarkCharacters(UWorld* World, UClass* CharacterClass, int32 NumCharacters, TArray<ARPGCharacterBase*>& OutCharacters)
+{
+	const int32 RowLength = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumCharacters)));
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	const double StartTime = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < NumCharacters; Index++)
+	{
+		const FVector Location(200.0f * (Index % RowLength), 200.0f * (Index / RowLength), 100.0f);
+		ARPGCharacterBase* Character = World->SpawnActor<ARPGCharacterBase>(CharacterClass, Location, FRotator::ZeroRotator, SpawnParameters);
+
+		if (Character)
+		{
+			OutCharacters.Add(Character);
+		}
+	}
+	return FPlatformTime::Seconds() - StartTime;
+}
+
+static void DestroyBenchmarkCharacters(TArray<ARPGCharacterBase*>& Characters)
+{
+	for (ARPGCharacterBase* Character : Characters)
+	{
+		AController* Controller = Character->GetController();
+		Character->Destroy();
+
+		if (Controller)
+		{
+			Controller->Destroy();
+		}
+	}
+	Characters.Reset();
+}
+
+static void BenchmarkGrantTemplates(const TArray<FString>& Args, UWorld* World)
+{
+	if (Args.Num() < 1)
+	{
+		UE_LOG(LogActionRPG, Display, TEXT("Usage: RPG.Abilities.BenchmarkSpawn <CharacterClassPath> [NumCharacters]"));
+		return;
+	}
+
+	UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	URPGAbilityGrantSubsystem* GrantSubsystem = GameInstance ? GameInstance->GetSubsystem<URPGAbilityGrantSubsystem>() : nullptr;
+
+	if (!GrantSubsystem || World->GetNetMode() == NM_Client)
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("Grant template benchmark: needs a game world with authority"));
+		return;
+	}
+
+	UClass* CharacterClass = LoadClass<ARPGCharacterBase>(nullptr, *Args[0]);
+	if (!CharacterClass)
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("Grant template benchmark: %s is not a character class"), *Args[0]);
+		return;
+	}
+
+	const int32 NumCharacters = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 100;
+	const int32 OldUseGrantTemplates = GRPGUseGrantTemplates;
+	TArray<ARPGCharacterBase*> Characters;
+	Characters.Reserve(NumCharacters);
+
+	// Every character in a batch is spawned in the same frame, like a wave
+	GRPGUseGrantTemplates = 0;
+	const double UniqueSeconds = SpawnBenchmarkCharacters(World, CharacterClass, NumCharacters, Characters);
+	DestroyBenchmarkCharacters(Characters);
+
+	// The first batch pays for building the template
+	GRPGUseGrantTemplates = 1;
+	GrantSubsystem->ResetTemplates();
+	const double ColdSeconds = SpawnBenchmarkCharacters(World, CharacterClass, NumCharacters, Characters);
+	DestroyBenchmarkCharacters(Characters);
+
+	const double WarmSeconds = SpawnBenchmarkCharacters(World, CharacterClass, NumCharacters, Characters);
+	DestroyBenchmarkCharacters(Characters);
+
+	GRPGUseGrantTemplates = OldUseGrantTemplates;
+
+	UE_LOG(LogActionRPG, Display, TEXT("Grant template benchmark: %d x %s, per instance grants %.2f ms (%.1f us each), cold template %.2f ms (%.1f us each), warm template %.2f ms (%.1f us each)"),
+		NumCharacters, *CharacterClass->GetName(),
+		UniqueSeconds * 1000.0, UniqueSeconds * 1.0e6 / NumCharacters,
+		ColdSeconds * 1000.0, ColdSeconds * 1.0e6 / NumCharacters,
+		WarmSeconds * 1000.0, WarmSeconds * 1.0e6 / NumCharacters);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkGrantTemplatesCommand(
+	TEXT("RPG.Abilities.BenchmarkSpawn"),
+	TEXT("Spawns a wave of characters with and without grant templates and logs the spawn times. Arguments are the character class path and the number of characters, 100 by default"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkGrantTemplates));
+
+#endif
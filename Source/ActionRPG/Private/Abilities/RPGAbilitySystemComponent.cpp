@@ -3,26 +3,149 @@
 #include "Abilities/RPGAbilitySystemComponent.h"
 #include "RPGCharacterBase.h"
 #include "Abilities/RPGGameplayAbility.h"
+#include "Abilities/RPGAbilityGrantSubsystem.h"
 #include "AbilitySystemGlobals.h"
 
-URPGAbilitySystemComponent::URPGAbilitySystemComponent() {}
+URPGAbilitySystemComponent::URPGAbilitySystemComponent()
+	: AbilityTagIndexSpecNum(0)
+	, bAbilityTagIndexDirty(true)
+{}
+
+void URPGAbilitySystemComponent::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	CooldownRootTag = FGameplayTag::RequestGameplayTag(TEXT("Cooldown"), false);
+
+	if (CooldownRootTag.IsValid())
+	{
+		// Called on both server and clients for effects with a duration
+		OnActiveGameplayEffectAddedDelegateToSelf.AddUObject(this, &URPGAbilitySystemComponent::HandleCooldownEffectAdded);
+		OnAnyGameplayEffectRemovedDelegate().AddUObject(this, &URPGAbilitySystemComponent::HandleCooldownEffectRemoved);
+	}
+}
 
 void URPGAbilitySystemComponent::GetActiveAbilitiesWithTags(const FGameplayTagContainer& GameplayTagContainer, TArray<URPGGameplayAbility*>& ActiveAbilities)
 {
-	TArray<FGameplayAbilitySpec*> AbilitiesToActivate;
-	GetActivatableGameplayAbilitySpecsByAllMatchingTags(GameplayTagContainer, AbilitiesToActivate, false);
+	ForEachActiveAbilityWithTags(GameplayTagContainer, [&ActiveAbilities](URPGGameplayAbility* ActiveAbility)
+	{
+		ActiveAbilities.Add(ActiveAbility);
+	});
+}
+
+void URPGAbilitySystemComponent::ForEachActiveAbilityWithTags(const FGameplayTagContainer& GameplayTagContainer, TFunctionRef<void(URPGGameplayAbility*)> Visitor)
+{
+	// Keeps the spec list and the index stable while visiting
+	ABILITYLIST_SCOPE_LOCK();
+
+	const TArray<FGameplayAbilitySpec>& Specs = ActivatableAbilities.Items;
+
+	if (GameplayTagContainer.IsEmpty())
+	{
+		// Every ability has all of no tags
+		for (const FGameplayAbilitySpec& Spec : Specs)
+		{
+			ForEachAbilityInstance(Spec, Visitor);
+		}
+		return;
+	}
+
+	UpdateAbilityTagIndex();
+
+	// Only specs listed under every tag can match, so the shortest list is enough to check
+	const TArray<int32>* Candidates = nullptr;
+	for (const FGameplayTag& Tag : GameplayTagContainer)
+	{
+		const TArray<int32>* TagSpecs = AbilityTagIndex.Find(Tag);
+
+		if (!TagSpecs)
+		{
+			return;
+		}
+
+		if (!Candidates || TagSpecs->Num() < Candidates->Num())
+		{
+			Candidates = TagSpecs;
+		}
+	}
+
+	for (int32 SpecIndex : *Candidates)
+	{
+		const FGameplayAbilitySpec& Spec = Specs[SpecIndex];
+
+		if (Spec.Ability && Spec.Ability->AbilityTags.HasAll(GameplayTagContainer))
+		{
+			ForEachAbilityInstance(Spec, Visitor);
+		}
+	}
+}
+
+void URPGAbilitySystemComponent::ForEachAbilityInstance(const FGameplayAbilitySpec& Spec, TFunctionRef<void(URPGGameplayAbility*)> Visitor)
+{
+	// Same instances as GetAbilityInstances, read in place
+	for (UGameplayAbility* Instance : Spec.ReplicatedInstances)
+	{
+		if (URPGGameplayAbility* RPGInstance = Cast<URPGGameplayAbility>(Instance))
+		{
+			Visitor(RPGInstance);
+		}
+	}
+
+	for (UGameplayAbility* Instance : Spec.NonReplicatedInstances)
+	{
+		if (URPGGameplayAbility* RPGInstance = Cast<URPGGameplayAbility>(Instance))
+		{
+			Visitor(RPGInstance);
+		}
+	}
+}
+
+void URPGAbilitySystemComponent::OnGiveAbility(FGameplayAbilitySpec& AbilitySpec)
+{
+	Super::OnGiveAbility(AbilitySpec);
+
+	bAbilityTagIndexDirty = true;
+}
+
+void URPGAbilitySystemComponent::OnRemoveAbility(FGameplayAbilitySpec& AbilitySpec)
+{
+	Super::OnRemoveAbility(AbilitySpec);
+
+	bAbilityTagIndexDirty = true;
+}
+
+void URPGAbilitySystemComponent::UpdateAbilityTagIndex()
+{
+	const TArray<FGameplayAbilitySpec>& Specs = ActivatableAbilities.Items;
+
+	// Also rebuilt if the list size changed without a give or remove callback
+	if (!bAbilityTagIndexDirty && AbilityTagIndexSpecNum == Specs.Num())
+	{
+		return;
+	}
+
+	for (TPair<FGameplayTag, TArray<int32>>& Pair : AbilityTagIndex)
+	{
+		// Keep the allocations, the same tags come back when abilities are given again
+		Pair.Value.Reset();
+	}
 
-	// Iterate the list of all ability specs
-	for (FGameplayAbilitySpec* Spec : AbilitiesToActivate)
+	for (int32 SpecIndex = 0; SpecIndex < Specs.Num(); SpecIndex++)
 	{
-		// Iterate all instances on this ability spec
-		TArray<UGameplayAbility*> AbilityInstances = Spec->GetAbilityInstances();
+		const UGameplayAbility* Ability = Specs[SpecIndex].Ability;
 
-		for (UGameplayAbility* ActiveAbility : AbilityInstances)
+		if (Ability)
 		{
-			ActiveAbilities.Add(Cast<URPGGameplayAbility>(ActiveAbility));
+			// A query for a parent tag matches abilities with a child tag
+			for (const FGameplayTag& Tag : Ability->AbilityTags.GetGameplayTagParents())
+			{
+				AbilityTagIndex.FindOrAdd(Tag).Add(SpecIndex);
+			}
 		}
 	}
+
+	AbilityTagIndexSpecNum = Specs.Num();
+	bAbilityTagIndexDirty = false;
 }
 
 int32 URPGAbilitySystemComponent::GetDefaultAbilityLevel() const
@@ -36,6 +159,194 @@ int32 URPGAbilitySystemComponent::GetDefaultAbilityLevel() const
 	return 1;
 }
 
+void URPGAbilitySystemComponent::ApplyGrantTemplate(const FRPGAbilityGrantTemplate& GrantTemplate, UObject* SourceObject, TArray<FActiveGameplayEffectHandle>& OutPassiveEffectHandles)
+{
+	// Grow the spec list once instead of once per ability
+	ActivatableAbilities.Items.Reserve(ActivatableAbilities.Items.Num() + GrantTemplate.Abilities.Num());
+
+	for (const TSubclassOf<URPGGameplayAbility>& Ability : GrantTemplate.Abilities)
+	{
+		GiveAbility(FGameplayAbilitySpec(Ability, GrantTemplate.Level, INDEX_NONE, SourceObject));
+	}
+
+	if (GrantTemplate.PassiveEffects.Num() == 0)
+	{
+		return;
+	}
+
+	FGameplayEffectContextHandle EffectContext = MakeEffectContext();
+	EffectContext.AddSourceObject(SourceObject);
+
+	OutPassiveEffectHandles.Reserve(OutPassiveEffectHandles.Num() + GrantTemplate.PassiveEffects.Num());
+	for (const FGameplayEffectSpec& TemplateSpec : GrantTemplate.PassiveEffects)
+	{
+		// The template has no context, so source tags and attributes are captured here
+		FGameplayEffectSpec Spec(TemplateSpec);
+		Spec.SetContext(EffectContext);
+		Spec.CaptureDataFromSource();
+
+		FActiveGameplayEffectHandle ActiveGEHandle = ApplyGameplayEffectSpecToSelf(Spec);
+		if (ActiveGEHandle.IsValid())
+		{
+			OutPassiveEffectHandles.Add(ActiveGEHandle);
+		}
+	}
+}
+
+bool URPGAbilitySystemComponent::IsCooldownTag(const FGameplayTag& Tag) const
+{
+	return CooldownRootTag.IsValid() && Tag.MatchesTag(CooldownRootTag);
+}
+
+bool URPGAbilitySystemComponent::GetCooldownRemaining(const FGameplayTagContainer& CooldownTags, float& TimeRemaining, float& CooldownDuration) const
+{
+	const FCooldownEntry* LongestEntry = nullptr;
+	float LongestTime = 0.0f;
+	const float WorldTime = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.0f;
+
+	for (const FGameplayTag& CooldownTag : CooldownTags)
+	{
+		const TArray<FCooldownEntry, TInlineAllocator<2>>* Entries = CooldownTable.Find(CooldownTag);
+
+		if (!Entries)
+		{
+			continue;
+		}
+
+		for (const FCooldownEntry& Entry : *Entries)
+		{
+			// Same as FActiveGameplayEffect::GetTimeRemaining
+			const float EntryTime = Entry.Duration == FGameplayEffectConstants::INFINITE_DURATION ? -1.0f : Entry.Duration - (WorldTime - Entry.StartWorldTime);
+
+			if (!LongestEntry || EntryTime > LongestTime)
+			{
+				LongestEntry = &Entry;
+				LongestTime = EntryTime;
+			}
+		}
+	}
+
+	if (LongestEntry)
+	{
+		TimeRemaining = LongestTime;
+		CooldownDuration = LongestEntry->Duration;
+		return true;
+	}
+	return false;
+}
+
+void URPGAbilitySystemComponent::HandleCooldownEffectAdded(UAbilitySystemComponent* Target, const FGameplayEffectSpec& Spec, FActiveGameplayEffectHandle ActiveHandle)
+{
+	// Same tags the owning tag query this replaces matches, asset and granted tags together
+	FGameplayTagContainer EffectTags;
+	Spec.GetAllAssetTags(EffectTags);
+	Spec.GetAllGrantedTags(EffectTags);
+
+	// Collect cooldown tags with their parents, as a query for a parent matches the child
+	FGameplayTagContainer CooldownTags;
+	for (const FGameplayTag& EffectTag : EffectTags)
+	{
+		if (IsCooldownTag(EffectTag))
+		{
+			CooldownTags.AppendTags(EffectTag.GetGameplayTagParents());
+		}
+	}
+
+	const FActiveGameplayEffect* ActiveEffect = GetActiveGameplayEffect(ActiveHandle);
+	if (CooldownTags.Num() == 0 || !ActiveEffect || CooldownEffectTags.Contains(ActiveHandle))
+	{
+		return;
+	}
+
+	FCooldownEntry NewEntry;
+	NewEntry.Handle = ActiveHandle;
+	NewEntry.StartWorldTime = ActiveEffect->StartWorldTime;
+	NewEntry.Duration = ActiveEffect->GetDuration();
+
+	for (const FGameplayTag& CooldownTag : CooldownTags)
+	{
+		CooldownTable.FindOrAdd(CooldownTag).Add(NewEntry);
+	}
+	CooldownEffectTags.Add(ActiveHandle, MoveTemp(CooldownTags));
+
+	// Stacking can refresh the duration, which also triggers a time change
+	if (FOnActiveGameplayEffectStackChange* StackChangeDelegate = OnGameplayEffectStackChangeDelegate(ActiveHandle))
+	{
+		StackChangeDelegate->AddUObject(this, &URPGAbilitySystemComponent::HandleCooldownEffectStackChanged);
+	}
+
+	if (FOnActiveGameplayEffectTimeChange* TimeChangeDelegate = OnGameplayEffectTimeChangeDelegate(ActiveHandle))
+	{
+		TimeChangeDelegate->AddUObject(this, &URPGAbilitySystemComponent::HandleCooldownEffectTimeChanged);
+	}
+}
+
+void URPGAbilitySystemComponent::HandleCooldownEffectRemoved(const FActiveGameplayEffect& ActiveEffect)
+{
+	FGameplayTagContainer CooldownTags;
+	if (!CooldownEffectTags.RemoveAndCopyValue(ActiveEffect.Handle, CooldownTags))
+	{
+		return;
+	}
+
+	for (const FGameplayTag& CooldownTag : CooldownTags)
+	{
+		TArray<FCooldownEntry, TInlineAllocator<2>>* Entries = CooldownTable.Find(CooldownTag);
+
+		if (Entries)
+		{
+			Entries->RemoveAllSwap([&ActiveEffect](const FCooldownEntry& Entry) { return Entry.Handle == ActiveEffect.Handle; });
+
+			if (Entries->Num() == 0)
+			{
+				CooldownTable.Remove(CooldownTag);
+			}
+		}
+	}
+}
+
+void URPGAbilitySystemComponent::HandleCooldownEffectStackChanged(FActiveGameplayEffectHandle ActiveHandle, int32 NewStackCount, int32 PreviousStackCount)
+{
+	const FActiveGameplayEffect* ActiveEffect = GetActiveGameplayEffect(ActiveHandle);
+
+	if (ActiveEffect)
+	{
+		UpdateCooldownEntries(ActiveHandle, ActiveEffect->StartWorldTime, ActiveEffect->GetDuration());
+	}
+}
+
+void URPGAbilitySystemComponent::HandleCooldownEffectTimeChanged(FActiveGameplayEffectHandle ActiveHandle, float NewStartTime, float NewDuration)
+{
+	UpdateCooldownEntries(ActiveHandle, NewStartTime, NewDuration);
+}
+
+void URPGAbilitySystemComponent::UpdateCooldownEntries(FActiveGameplayEffectHandle ActiveHandle, float StartWorldTime, float Duration)
+{
+	const FGameplayTagContainer* CooldownTags = CooldownEffectTags.Find(ActiveHandle);
+
+	if (!CooldownTags)
+	{
+		return;
+	}
+
+	for (const FGameplayTag& CooldownTag : *CooldownTags)
+	{
+		TArray<FCooldownEntry, TInlineAllocator<2>>* Entries = CooldownTable.Find(CooldownTag);
+
+		if (Entries)
+		{
+			for (FCooldownEntry& Entry : *Entries)
+			{
+				if (Entry.Handle == ActiveHandle)
+				{
+					Entry.StartWorldTime = StartWorldTime;
+					Entry.Duration = Duration;
+				}
+			}
+		}
+	}
+}
+
 URPGAbilitySystemComponent* URPGAbilitySystemComponent::GetAbilitySystemComponentFromActor(const AActor* Actor, bool LookForComponent)
 {
 	return Cast<URPGAbilitySystemComponent>(UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Actor, LookForComponent));
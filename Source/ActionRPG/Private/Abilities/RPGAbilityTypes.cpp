@@ -2,6 +2,7 @@
 
 #include "Abilities/RPGAbilityTypes.h"
 #include "Abilities/RPGAbilitySystemComponent.h"
+#include "Abilities/RPGDamageExecution.h"
 #include "AbilitySystemGlobals.h"
 
 bool FRPGGameplayEffectContainerSpec::HasValidEffects() const
@@ -16,10 +17,16 @@ bool FRPGGameplayEffectContainerSpec::HasValidTargets() const
 
 void FRPGGameplayEffectContainerSpec::AddTargets(const TArray<FHitResult>& HitResults, const TArray<AActor*>& TargetActors)
 {
-	for (const FHitResult& HitResult : HitResults)
+	if (HitResults.Num() > 0)
 	{
-		FGameplayAbilityTargetData_SingleTargetHit* NewData = new FGameplayAbilityTargetData_SingleTargetHit(HitResult);
-		TargetData.Add(NewData);
+		TSharedRef<FRPGGameplayAbilityTargetData_MultiHit> NewData = FRPGGameplayAbilityTargetData_MultiHit::Allocate();
+		NewData->Hits.Reserve(HitResults.Num());
+
+		for (const FHitResult& HitResult : HitResults)
+		{
+			NewData->Hits.Emplace(HitResult);
+		}
+		TargetData.Data.Add(NewData);
 	}
 
 	if (TargetActors.Num() > 0)
@@ -28,4 +35,166 @@ void FRPGGameplayEffectContainerSpec::AddTargets(const TArray<FHitResult>& HitRe
 		NewData->TargetActorArray.Append(TargetActors);
 		TargetData.Add(NewData);
 	}
-}
\ No newline at end of file
+}
+
+TArray<FActiveGameplayEffectHandle> FRPGGameplayEffectContainerSpec::ApplyEffectSpecToTargets(FGameplayEffectSpec& Spec, FPredictionKey PredictionKey) const
+{
+	TArray<FActiveGameplayEffectHandle> AppliedHandles;
+
+	// Every target gets a copy of the spec, this lets damage executions of those copies share the source side
+	const FRPGDamageSourceScope DamageSourceScope(Spec);
+
+	for (const TSharedPtr<FGameplayAbilityTargetData>& Data : TargetData.Data)
+	{
+		if (!Data.IsValid())
+		{
+			continue;
+		}
+
+		// Multi hit data has to be applied per hit, the engine path would drop the hit results
+		if (Data->GetScriptStruct() == FRPGGameplayAbilityTargetData_MultiHit::StaticStruct())
+		{
+			AppliedHandles.Append(static_cast<const FRPGGameplayAbilityTargetData_MultiHit*>(Data.Get())->ApplyGameplayEffectSpecToHits(Spec, PredictionKey));
+		}
+		else
+		{
+			AppliedHandles.Append(Data->ApplyGameplayEffectSpec(Spec, PredictionKey));
+		}
+	}
+	return AppliedHandles;
+}
+
+FRPGCompactHit::FRPGCompactHit(const FHitResult& HitResult)
+	: Actor(HitResult.GetActor())
+	, Location(HitResult.ImpactPoint)
+	, Normal(HitResult.ImpactNormal)
+	, BoneName(HitResult.BoneName)
+{
+}
+
+FHitResult FRPGCompactHit::ToHitResult() const
+{
+	FHitResult HitResult(Actor.Get(), nullptr, Location, Normal);
+	HitResult.BoneName = BoneName;
+	return HitResult;
+}
+
+/** Released multi hit data waiting to be reused, only used on the game thread */
+struct FRPGMultiHitTargetDataPool
+{
+	TArray<FRPGGameplayAbilityTargetData_MultiHit*> FreeData;
+
+	~FRPGMultiHitTargetDataPool()
+	{
+		for (FRPGGameplayAbilityTargetData_MultiHit* Data : FreeData)
+		{
+			delete Data;
+		}
+	}
+};
+
+static FRPGMultiHitTargetDataPool GRPGMultiHitTargetDataPool;
+
+/** Pool size and the largest hit array kept, so one huge targeting pass doesn't hold on to its memory */
+static const int32 MaxPooledMultiHitData = 64;
+static const int32 MaxPooledHitCapacity = 256;
+
+TSharedRef<FRPGGameplayAbilityTargetData_MultiHit> FRPGGameplayAbilityTargetData_MultiHit::Allocate()
+{
+	FRPGGameplayAbilityTargetData_MultiHit* Data = nullptr;
+
+	if (IsInGameThread() && GRPGMultiHitTargetDataPool.FreeData.Num() > 0)
+	{
+		Data = GRPGMultiHitTargetDataPool.FreeData.Pop(EAllowShrinking::No);
+	}
+	else
+	{
+		Data = new FRPGGameplayAbilityTargetData_MultiHit();
+	}
+	return MakeShareable(Data, &FRPGGameplayAbilityTargetData_MultiHit::Release);
+}
+
+void FRPGGameplayAbilityTargetData_MultiHit::Release(FRPGGameplayAbilityTargetData_MultiHit* Data)
+{
+	if (IsInGameThread() && GRPGMultiHitTargetDataPool.FreeData.Num() < MaxPooledMultiHitData && Data->Hits.Max() <= MaxPooledHitCapacity)
+	{
+		// Keep the hit array allocation for the next pass
+		Data->Hits.Reset();
+		GRPGMultiHitTargetDataPool.FreeData.Add(Data);
+	}
+	else
+	{
+		delete Data;
+	}
+}
+
+TArray<FActiveGameplayEffectHandle> FRPGGameplayAbilityTargetData_MultiHit::ApplyGameplayEffectSpecToHits(FGameplayEffectSpec& Spec, FPredictionKey PredictionKey) const
+{
+	TArray<FActiveGameplayEffectHandle> AppliedHandles;
+	UAbilitySystemComponent* SourceComponent = Spec.GetContext().GetInstigatorAbilitySystemComponent();
+
+	if (!ensure(SourceComponent))
+	{
+		return AppliedHandles;
+	}
+
+	AppliedHandles.Reserve(Hits.Num());
+	for (const FRPGCompactHit& Hit : Hits)
+	{
+		UAbilitySystemComponent* TargetComponent = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Hit.Actor.Get());
+
+		if (TargetComponent)
+		{
+			// Every target gets its own context, otherwise the hit results would pile up in the shared one
+			FGameplayEffectSpec SpecToApply(Spec);
+			FGameplayEffectContextHandle EffectContext = SpecToApply.GetContext().Duplicate();
+			SpecToApply.SetContext(EffectContext);
+			EffectContext.AddHitResult(Hit.ToHitResult(), true);
+
+			AppliedHandles.Add(SourceComponent->ApplyGameplayEffectSpecToTarget(SpecToApply, TargetComponent, PredictionKey));
+		}
+	}
+	return AppliedHandles;
+}
+
+TArray<TWeakObjectPtr<AActor>> FRPGGameplayAbilityTargetData_MultiHit::GetActors() const
+{
+	TArray<TWeakObjectPtr<AActor>> Actors;
+	Actors.Reserve(Hits.Num());
+
+	for (const FRPGCompactHit& Hit : Hits)
+	{
+		Actors.Add(Hit.Actor);
+	}
+	return Actors;
+}
+
+UScriptStruct* FRPGGameplayAbilityTargetData_MultiHit::GetScriptStruct() const
+{
+	return FRPGGameplayAbilityTargetData_MultiHit::StaticStruct();
+}
+
+FString FRPGGameplayAbilityTargetData_MultiHit::ToString() const
+{
+	return FString::Printf(TEXT("FRPGGameplayAbilityTargetData_MultiHit (%d hits)"), Hits.Num());
+}
+
+bool FRPGGameplayAbilityTargetData_MultiHit::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	SafeNetSerializeTArray_HeaderOnly<1023>(Ar, Hits);
+	bOutSuccess = true;
+
+	for (FRPGCompactHit& Hit : Hits)
+	{
+		bool bLocationSuccess = true;
+		bool bNormalSuccess = true;
+
+		Ar << Hit.Actor;
+		Hit.Location.NetSerialize(Ar, Map, bLocationSuccess);
+		Hit.Normal.NetSerialize(Ar, Map, bNormalSuccess);
+		Ar << Hit.BoneName;
+
+		bOutSuccess &= bLocationSuccess && bNormalSuccess;
+	}
+	return true;
+}
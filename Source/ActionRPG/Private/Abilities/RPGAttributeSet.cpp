@@ -2,9 +2,67 @@
 
 #include "Abilities/RPGAttributeSet.h"
 #include "Abilities/RPGAbilitySystemComponent.h"
+#include "Abilities/RPGDamageEventSubsystem.h"
 #include "RPGCharacterBase.h"
 #include "GameplayEffect.h"
 #include "GameplayEffectExtension.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+
+static int32 GRPGQuantizeProxyVitals = 0;
+static FAutoConsoleVariableRef CVarRPGQuantizeProxyVitals(
+	TEXT("RPG.Attributes.QuantizeProxyVitals"),
+	GRPGQuantizeProxyVitals,
+	TEXT("If non zero, simulated proxies receive Health, Mana and MoveSpeed as packed tenths instead of full attributes. Read when replication is set up, so set it in an ini"),
+	ECVF_ReadOnly);
+
+/** Quantization step of FRPGQuantizedVitals */
+static const float QuantizedVitalsScale = 10.0f;
+
+static void SerializeQuantizedValue(FArchive& Ar, float& Value)
+{
+	// Vitals are never negative, and packing keeps small values small
+	uint32 Quantized = Ar.IsSaving() ? static_cast<uint32>(FMath::RoundToInt(FMath::Max(Value, 0.0f) * QuantizedVitalsScale)) : 0;
+	Ar.SerializeIntPacked(Quantized);
+
+	if (Ar.IsLoading())
+	{
+		Value = Quantized / QuantizedVitalsScale;
+	}
+}
+
+static void SerializeQuantizedAttribute(FArchive& Ar, FGameplayAttributeData& AttributeData)
+{
+	float BaseValue = AttributeData.GetBaseValue();
+	float CurrentValue = AttributeData.GetCurrentValue();
+
+	uint8 bCurrentIsBase = BaseValue == CurrentValue ? 1 : 0;
+	Ar.SerializeBits(&bCurrentIsBase, 1);
+
+	SerializeQuantizedValue(Ar, BaseValue);
+	if (!bCurrentIsBase)
+	{
+		SerializeQuantizedValue(Ar, CurrentValue);
+	}
+
+	if (Ar.IsLoading())
+	{
+		AttributeData.SetBaseValue(BaseValue);
+		AttributeData.SetCurrentValue(bCurrentIsBase ? BaseValue : CurrentValue);
+	}
+}
+
+bool FRPGQuantizedVitals::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	SerializeQuantizedAttribute(Ar, Health);
+	SerializeQuantizedAttribute(Ar, Mana);
+	SerializeQuantizedAttribute(Ar, MoveSpeed);
+
+	bOutSuccess = true;
+	return true;
+}
 
 URPGAttributeSet::URPGAttributeSet()
 	: Health(1.f)
@@ -16,19 +74,103 @@ URPGAttributeSet::URPGAttributeSet()
 	, MoveSpeed(1.0f)
 	, Damage(0.0f)
 {
+	QuantizedVitals.Health = Health;
+	QuantizedVitals.Mana = Mana;
+	QuantizedVitals.MoveSpeed = MoveSpeed;
 }
 
 void URPGAttributeSet::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(URPGAttributeSet, Health);
-	DOREPLIFETIME(URPGAttributeSet, MaxHealth);
-	DOREPLIFETIME(URPGAttributeSet, Mana);
-	DOREPLIFETIME(URPGAttributeSet, MaxMana);
-	DOREPLIFETIME(URPGAttributeSet, AttackPower);
-	DOREPLIFETIME(URPGAttributeSet, DefensePower);
-	DOREPLIFETIME(URPGAttributeSet, MoveSpeed);
+	// Attributes only change when effects are applied, so they are compared when marked dirty instead of every update
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(URPGAttributeSet, MaxHealth, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(URPGAttributeSet, MaxMana, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(URPGAttributeSet, AttackPower, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(URPGAttributeSet, DefensePower, Params);
+
+	// With quantized vitals, only the owner gets the full values
+	FDoRepLifetimeParams VitalsParams = Params;
+	VitalsParams.Condition = IsQuantizingProxyVitals() ? COND_AutonomousOnly : COND_None;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(URPGAttributeSet, Health, VitalsParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(URPGAttributeSet, Mana, VitalsParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(URPGAttributeSet, MoveSpeed, VitalsParams);
+
+	FDoRepLifetimeParams QuantizedParams = Params;
+	QuantizedParams.Condition = IsQuantizingProxyVitals() ? COND_SimulatedOnly : COND_Never;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(URPGAttributeSet, QuantizedVitals, QuantizedParams);
+}
+
+bool URPGAttributeSet::IsQuantizingProxyVitals()
+{
+	return GRPGQuantizeProxyVitals != 0;
+}
+
+void URPGAttributeSet::MarkAttributeDirty(const FGameplayAttribute& Attribute)
+{
+	if (Attribute == GetHealthAttribute())
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(URPGAttributeSet, Health, this);
+	}
+	else if (Attribute == GetMaxHealthAttribute())
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(URPGAttributeSet, MaxHealth, this);
+	}
+	else if (Attribute == GetManaAttribute())
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(URPGAttributeSet, Mana, this);
+	}
+	else if (Attribute == GetMaxManaAttribute())
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(URPGAttributeSet, MaxMana, this);
+	}
+	else if (Attribute == GetAttackPowerAttribute())
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(URPGAttributeSet, AttackPower, this);
+	}
+	else if (Attribute == GetDefensePowerAttribute())
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(URPGAttributeSet, DefensePower, this);
+	}
+	else if (Attribute == GetMoveSpeedAttribute())
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(URPGAttributeSet, MoveSpeed, this);
+	}
+	else
+	{
+		// Damage is not replicated
+		return;
+	}
+
+	if (IsQuantizingProxyVitals() && (Attribute == GetHealthAttribute() || Attribute == GetManaAttribute() || Attribute == GetMoveSpeedAttribute()))
+	{
+		QuantizedVitals.Health = Health;
+		QuantizedVitals.Mana = Mana;
+		QuantizedVitals.MoveSpeed = MoveSpeed;
+		MARK_PROPERTY_DIRTY_FROM_NAME(URPGAttributeSet, QuantizedVitals, this);
+	}
+}
+
+void URPGAttributeSet::PostAttributeChange(const FGameplayAttribute& Attribute, float OldValue, float NewValue)
+{
+	Super::PostAttributeChange(Attribute, OldValue, NewValue);
+
+	// Called for every change of a current value, including ones caused by a max value changing
+	MarkAttributeDirty(Attribute);
+}
+
+void URPGAttributeSet::PostAttributeBaseChange(const FGameplayAttribute& Attribute, float OldValue, float NewValue) const
+{
+	Super::PostAttributeBaseChange(Attribute, OldValue, NewValue);
+
+	// The base value replicates too, and changes to it don't call PostAttributeChange while a modifier keeps the current value the same.
+	// The engine declares this const, marking dirty only touches replication state
+	const_cast<URPGAttributeSet*>(this)->MarkAttributeDirty(Attribute);
 }
 
 void URPGAttributeSet::OnRep_Health(const FGameplayAttributeData& OldValue)
@@ -66,6 +208,26 @@ void URPGAttributeSet::OnRep_MoveSpeed(const FGameplayAttributeData& OldValue)
 	GAMEPLAYATTRIBUTE_REPNOTIFY(URPGAttributeSet, MoveSpeed, OldValue);
 }
 
+void URPGAttributeSet::OnRep_QuantizedVitals()
+{
+	ApplyQuantizedAttribute(Health, GetHealthAttribute(), QuantizedVitals.Health);
+	ApplyQuantizedAttribute(Mana, GetManaAttribute(), QuantizedVitals.Mana);
+	ApplyQuantizedAttribute(MoveSpeed, GetMoveSpeedAttribute(), QuantizedVitals.MoveSpeed);
+}
+
+void URPGAttributeSet::ApplyQuantizedAttribute(FGameplayAttributeData& AttributeData, const FGameplayAttribute& Attribute, const FGameplayAttributeData& NewValue)
+{
+	if (AttributeData.GetBaseValue() == NewValue.GetBaseValue() && AttributeData.GetCurrentValue() == NewValue.GetCurrentValue())
+	{
+		return;
+	}
+
+	// Same as a normal rep notify, with the property already holding the new value
+	const FGameplayAttributeData OldValue = AttributeData;
+	AttributeData = NewValue;
+	GetOwningAbilitySystemComponentChecked()->SetBaseAttributeValueFromReplication(Attribute, AttributeData, OldValue);
+}
+
 void URPGAttributeSet::AdjustAttributeForMaxChange(FGameplayAttributeData& AffectedAttribute, const FGameplayAttributeData& MaxAttribute, float NewMaxValue, const FGameplayAttribute& AffectedAttributeProperty)
 {
 	UAbilitySystemComponent* AbilityComp = GetOwningAbilitySystemComponent();
@@ -99,8 +261,10 @@ void URPGAttributeSet::PostGameplayEffectExecute(const FGameplayEffectModCallbac
 {
 	Super::PostGameplayEffectExecute(Data);
 
+	// Instant effects change the base value, which doesn't call PostAttributeChange if the current value stays the same
+	MarkAttributeDirty(Data.EvaluatedData.Attribute);
+
 	FGameplayEffectContextHandle Context = Data.EffectSpec.GetContext();
-	UAbilitySystemComponent* Source = Context.GetOriginalInstigatorAbilitySystemComponent();
 	const FGameplayTagContainer& SourceTags = *Data.EffectSpec.CapturedSourceTags.GetAggregatedTags();
 
 	// Compute the delta between old and new, if it is available
@@ -124,46 +288,6 @@ void URPGAttributeSet::PostGameplayEffectExecute(const FGameplayEffectModCallbac
 
 	if (Data.EvaluatedData.Attribute == GetDamageAttribute())
 	{
-		// Get the Source actor
-		AActor* SourceActor = nullptr;
-		AController* SourceController = nullptr;
-		ARPGCharacterBase* SourceCharacter = nullptr;
-		if (Source && Source->AbilityActorInfo.IsValid() && Source->AbilityActorInfo->AvatarActor.IsValid())
-		{
-			SourceActor = Source->AbilityActorInfo->AvatarActor.Get();
-			SourceController = Source->AbilityActorInfo->PlayerController.Get();
-			if (SourceController == nullptr && SourceActor != nullptr)
-			{
-				if (APawn* Pawn = Cast<APawn>(SourceActor))
-				{
-					SourceController = Pawn->GetController();
-				}
-			}
-
-			// Use the controller to find the source pawn
-			if (SourceController)
-			{
-				SourceCharacter = Cast<ARPGCharacterBase>(SourceController->GetPawn());
-			}
-			else
-			{
-				SourceCharacter = Cast<ARPGCharacterBase>(SourceActor);
-			}
-
-			// Set the causer actor based on context if it's set
-			if (Context.GetEffectCauser())
-			{
-				SourceActor = Context.GetEffectCauser();
-			}
-		}
-
-		// Try to extract a hit result
-		FHitResult HitResult;
-		if (Context.GetHitResult())
-		{
-			HitResult = *Context.GetHitResult();
-		}
-
 		// Store a local copy of the amount of damage done and clear the damage attribute
 		const float LocalDamageDone = GetDamage();
 		SetDamage(0.f);
@@ -176,11 +300,30 @@ void URPGAttributeSet::PostGameplayEffectExecute(const FGameplayEffectModCallbac
 
 			if (TargetCharacter)
 			{
-				// This is proper damage
-				TargetCharacter->HandleDamage(LocalDamageDone, HitResult, SourceTags, SourceCharacter, SourceActor);
+				URPGDamageEventSubsystem* DamageEvents = URPGDamageEventSubsystem::GetForDeferredEvents(TargetCharacter);
+
+				if (DamageEvents)
+				{
+					// Source and hit result are looked up from the context when the events are dispatched
+					DamageEvents->QueueDamage(TargetCharacter, LocalDamageDone, Context, SourceTags);
+					DamageEvents->QueueHealthChange(TargetCharacter, -LocalDamageDone, SourceTags);
+				}
+				else
+				{
+					ARPGCharacterBase* SourceCharacter = nullptr;
+					AActor* SourceActor = nullptr;
+					GetDamageSource(Context, SourceCharacter, SourceActor);
+
+					// Try to extract a hit result
+					const FHitResult* HitResult = Context.GetHitResult();
+
+					// This is proper damage
+					const FHitResult& Hit = HitResult ? *HitResult : URPGDamageEventSubsystem::EmptyHitResult;
+					TargetCharacter->HandleDamage(LocalDamageDone, Hit, SourceTags, SourceCharacter, SourceActor);
 
-				// Call for all health changes
-				TargetCharacter->HandleHealthChanged(-LocalDamageDone, SourceTags);
+					// Call for all health changes
+					TargetCharacter->HandleHealthChanged(-LocalDamageDone, SourceTags);
+				}
 			}
 		}
 	}
@@ -192,8 +335,17 @@ void URPGAttributeSet::PostGameplayEffectExecute(const FGameplayEffectModCallbac
 
 		if (TargetCharacter)
 		{
+			URPGDamageEventSubsystem* DamageEvents = URPGDamageEventSubsystem::GetForDeferredEvents(TargetCharacter);
+
 			// Call for all health changes
-			TargetCharacter->HandleHealthChanged(DeltaValue, SourceTags);
+			if (DamageEvents)
+			{
+				DamageEvents->QueueHealthChange(TargetCharacter, DeltaValue, SourceTags);
+			}
+			else
+			{
+				TargetCharacter->HandleHealthChanged(DeltaValue, SourceTags);
+			}
 		}
 	}
 	else if (Data.EvaluatedData.Attribute == GetManaAttribute())
@@ -216,3 +368,221 @@ void URPGAttributeSet::PostGameplayEffectExecute(const FGameplayEffectModCallbac
 		}
 	}
 }
+
+void URPGAttributeSet::GetDamageSource(const FGameplayEffectContextHandle& Context, ARPGCharacterBase*& OutSourceCharacter, AActor*& OutSourceActor)
+{
+	UAbilitySystemComponent* Source = Context.GetOriginalInstigatorAbilitySystemComponent();
+
+	// Get the Source actor
+	AActor* SourceActor = nullptr;
+	AController* SourceController = nullptr;
+	ARPGCharacterBase* SourceCharacter = nullptr;
+	if (Source && Source->AbilityActorInfo.IsValid() && Source->AbilityActorInfo->AvatarActor.IsValid())
+	{
+		SourceActor = Source->AbilityActorInfo->AvatarActor.Get();
+		SourceController = Source->AbilityActorInfo->PlayerController.Get();
+		if (SourceController == nullptr && SourceActor != nullptr)
+		{
+			if (APawn* Pawn = Cast<APawn>(SourceActor))
+			{
+				SourceController = Pawn->GetController();
+			}
+		}
+
+		// Use the controller to find the source pawn
+		if (SourceController)
+		{
+			SourceCharacter = Cast<ARPGCharacterBase>(SourceController->GetPawn());
+		}
+		else
+		{
+			SourceCharacter = Cast<ARPGCharacterBase>(SourceActor);
+		}
+
+		// Set the causer actor based on context if it's set
+		if (Context.GetEffectCauser())
+		{
+			SourceActor = Context.GetEffectCauser();
+		}
+	}
+
+	OutSourceCharacter = SourceCharacter;
+	OutSourceActor = SourceActor;
+}
+
+#if !UE_BUILD_SHIPPING
+
+/** State of a running replication benchmark */
+struct FRPGReplicationBenchmark
+{
+	TWeakObjectPtr<UWorld> World;
+	TArray<TWeakObjectPtr<ARPGCharacterBase>> Characters;
+	FDelegateHandle PostActorTickHandle;
+	FDelegateHandle PostTickFlushHandle;
+	FDelegateHandle WorldCleanupHandle;
+	double WarmupEndTime;
+	double StartTime;
+	double Duration;
+	double FlushStartTime;
+	double FlushSeconds;
+	int32 NumFrames;
+	uint32 StartOutBytes;
+};
+
+static TUniquePtr<FRPGReplicationBenchmark> GRPGReplicationBenchmark;
+
+/** Logs the results and removes the characters, unless the world is being cleaned up and takes them with it */
+static void FinishReplicationBenchmark(bool bWorldCleanup)
+{
+	FRPGReplicationBenchmark& Benchmark = *GRPGReplicationBenchmark;
+	UWorld* World = Benchmark.World.Get();
+
+	FWorldDelegates::OnWorldPostActorTick.Remove(Benchmark.PostActorTickHandle);
+	FWorldDelegates::OnWorldCleanup.Remove(Benchmark.WorldCleanupHandle);
+
+	if (World)
+	{
+		World->OnPostTickFlush().Remove(Benchmark.PostTickFlushHandle);
+
+		UNetDriver* NetDriver = World->GetNetDriver();
+		const double Elapsed = FPlatformTime::Seconds() - Benchmark.StartTime;
+		const uint32 OutBytes = NetDriver ? NetDriver->OutTotalBytes - Benchmark.StartOutBytes : 0;
+
+		UE_LOG(LogActionRPG, Display, TEXT("Replication benchmark: %d characters, %d clients, push model %s, quantized vitals %s, %.3f ms/frame in net tick flush, %.0f bytes/s sent over %.1f s"),
+			Benchmark.Characters.Num(), NetDriver ? NetDriver->ClientConnections.Num() : 0,
+			IS_PUSH_MODEL_ENABLED() ? TEXT("on") : TEXT("off"), URPGAttributeSet::IsQuantizingProxyVitals() ? TEXT("on") : TEXT("off"),
+			Benchmark.NumFrames > 0 ? Benchmark.FlushSeconds * 1000.0 / Benchmark.NumFrames : 0.0, Elapsed > 0.0 ? OutBytes / Elapsed : 0.0, Elapsed);
+	}
+
+	for (const TWeakObjectPtr<ARPGCharacterBase>& Character : Benchmark.Characters)
+	{
+		if (!bWorldCleanup && Character.IsValid())
+		{
+			AController* Controller = Character->GetController();
+			Character->Destroy();
+
+			if (Controller)
+			{
+				Controller->Destroy();
+			}
+		}
+	}
+
+	GRPGReplicationBenchmark.Reset();
+}
+
+static void BenchmarkAttributeReplication(const TArray<FString>& Args, UWorld* World)
+{
+	if (Args.Num() < 1)
+	{
+		UE_LOG(LogActionRPG, Display, TEXT("Usage: RPG.Attributes.BenchmarkReplication <CharacterClassPath> [NumCharacters] [Seconds]"));
+		return;
+	}
+
+	if (GRPGReplicationBenchmark.IsValid())
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("Replication benchmark: already running"));
+		return;
+	}
+
+	UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+	if (!NetDriver || !NetDriver->IsServer())
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("Replication benchmark: needs to run on a server, ideally a dedicated server with clients connected"));
+		return;
+	}
+
+	UClass* CharacterClass = LoadClass<ARPGCharacterBase>(nullptr, *Args[0]);
+	if (!CharacterClass)
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("Replication benchmark: %s is not a character class"), *Args[0]);
+		return;
+	}
+
+	const int32 NumCharacters = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 100;
+	const double Duration = Args.Num() > 2 ? FMath::Max(1.0, FCString::Atod(*Args[2])) : 10.0;
+
+	GRPGReplicationBenchmark = MakeUnique<FRPGReplicationBenchmark>();
+	FRPGReplicationBenchmark& Benchmark = *GRPGReplicationBenchmark;
+	Benchmark.World = World;
+	Benchmark.StartTime = 0.0;
+	Benchmark.Duration = Duration;
+	Benchmark.FlushStartTime = 0.0;
+	Benchmark.FlushSeconds = 0.0;
+	Benchmark.NumFrames = 0;
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	const int32 RowLength = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumCharacters)));
+	for (int32 Index = 0; Index < NumCharacters; Index++)
+	{
+		const FVector Location(200.0f * (Index % RowLength), 200.0f * (Index / RowLength), 100.0f);
+		Benchmark.Characters.Add(World->SpawnActor<ARPGCharacterBase>(CharacterClass, Location, FRotator::ZeroRotator, SpawnParameters));
+	}
+
+	// Everything between the end of actor ticks and the end of the net tick flush is replication work
+	Benchmark.PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddLambda([](UWorld* TickedWorld, ELevelTick TickType, float DeltaSeconds)
+	{
+		if (GRPGReplicationBenchmark.IsValid() && GRPGReplicationBenchmark->World == TickedWorld)
+		{
+			GRPGReplicationBenchmark->FlushStartTime = FPlatformTime::Seconds();
+		}
+	});
+
+	Benchmark.PostTickFlushHandle = World->OnPostTickFlush().AddLambda([](float DeltaSeconds)
+	{
+		if (!GRPGReplicationBenchmark.IsValid())
+		{
+			return;
+		}
+
+		FRPGReplicationBenchmark& RunningBenchmark = *GRPGReplicationBenchmark;
+		const double Now = FPlatformTime::Seconds();
+
+		if (RunningBenchmark.StartTime == 0.0)
+		{
+			if (Now >= RunningBenchmark.WarmupEndTime)
+			{
+				UNetDriver* RunningNetDriver = RunningBenchmark.World.IsValid() ? RunningBenchmark.World->GetNetDriver() : nullptr;
+				RunningBenchmark.StartTime = Now;
+				RunningBenchmark.StartOutBytes = RunningNetDriver ? RunningNetDriver->OutTotalBytes : 0;
+			}
+			return;
+		}
+
+		if (RunningBenchmark.FlushStartTime > 0.0)
+		{
+			RunningBenchmark.FlushSeconds += Now - RunningBenchmark.FlushStartTime;
+			RunningBenchmark.NumFrames++;
+		}
+
+		if (Now - RunningBenchmark.StartTime >= RunningBenchmark.Duration)
+		{
+			FinishReplicationBenchmark(false);
+		}
+	});
+
+	// Leaving the map before the end would otherwise leave the benchmark running forever
+	Benchmark.WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddLambda([](UWorld* CleanedWorld, bool bSessionEnded, bool bCleanupResources)
+	{
+		if (GRPGReplicationBenchmark.IsValid() && GRPGReplicationBenchmark->World == CleanedWorld)
+		{
+			UE_LOG(LogActionRPG, Warning, TEXT("Replication benchmark: world was cleaned up before the measurement finished"));
+			FinishReplicationBenchmark(true);
+		}
+	});
+
+	// The initial replication of the new characters is not part of the steady state, so measuring starts a little later
+	Benchmark.WarmupEndTime = FPlatformTime::Seconds() + 2.0;
+	Benchmark.StartOutBytes = 0;
+
+	UE_LOG(LogActionRPG, Display, TEXT("Replication benchmark: spawned %d x %s, measuring for %.1f s"), NumCharacters, *CharacterClass->GetName(), Duration);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkAttributeReplicationCommand(
+	TEXT("RPG.Attributes.BenchmarkReplication"),
+	TEXT("Spawns characters on a server and logs the time spent replicating and the bytes sent per second. Arguments are the character class path, the number of characters (100) and the seconds to measure (10)"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkAttributeReplication));
+
+#endif
@@ -0,0 +1,346 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Abilities/RPGCharacterSpatialHash.h"
+#include "RPGCharacterBase.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "Engine/OverlapResult.h"
+#include "GameFramework/Controller.h"
+#include "HAL/IConsoleManager.h"
+
+static float GRPGSpatialHashCellSize = 500.0f;
+static FAutoConsoleVariableRef CVarRPGSpatialHashCellSize(
+	TEXT("RPG.SpatialHash.CellSize"),
+	GRPGSpatialHashCellSize,
+	TEXT("Size of the cells of the character spatial hash, should be about the radius of a typical area query"));
+
+URPGCharacterSpatialHash::URPGCharacterSpatialHash()
+	: BuiltFrame(0)
+	, BuiltCellSize(0.0f)
+	, MaxCapsuleRadius(0.0f)
+{
+}
+
+void URPGCharacterSpatialHash::RegisterCharacter(ARPGCharacterBase* Character)
+{
+	if (Character && !Characters.Contains(Character))
+	{
+		Characters.Add(Character);
+
+		// Rebuild so queries later this frame can find it
+		BuiltFrame = 0;
+	}
+}
+
+void URPGCharacterSpatialHash::UnregisterCharacter(ARPGCharacterBase* Character)
+{
+	if (Characters.RemoveSwap(Character) > 0)
+	{
+		// The grids may still point at it
+		BuiltFrame = 0;
+	}
+}
+
+int32 URPGCharacterSpatialHash::GetNumCharacters() const
+{
+	return Characters.Num();
+}
+
+uint64 URPGCharacterSpatialHash::GetCellKey(int32 CellX, int32 CellY) const
+{
+	return (static_cast<uint64>(static_cast<uint32>(CellX)) << 32) | static_cast<uint32>(CellY);
+}
+
+uint64 URPGCharacterSpatialHash::GetCellKey(const FVector& Location) const
+{
+	return GetCellKey(FMath::FloorToInt(Location.X / BuiltCellSize), FMath::FloorToInt(Location.Y / BuiltCellSize));
+}
+
+void URPGCharacterSpatialHash::UpdateGrids()
+{
+	if (BuiltFrame == GFrameCounter && BuiltFrame != 0)
+	{
+		return;
+	}
+
+	BuiltFrame = GFrameCounter;
+	BuiltCellSize = FMath::Max(GRPGSpatialHashCellSize, 1.0f);
+	MaxCapsuleRadius = 0.0f;
+
+	// Keep the allocations, the same teams come back every frame
+	for (FTeamGrid& TeamGrid : TeamGrids)
+	{
+		TeamGrid.Entries.Reset();
+		TeamGrid.Cells.Reset();
+	}
+
+	for (ARPGCharacterBase* Character : Characters)
+	{
+		if (!IsValid(Character) || Character->GetHealth() <= 0.0f)
+		{
+			continue;
+		}
+
+		// The team changes with possession, so it is read on every build
+		const FGenericTeamId TeamId = static_cast<const IGenericTeamAgentInterface*>(Character)->GetGenericTeamId();
+		FTeamGrid* TeamGrid = TeamGrids.FindByPredicate([TeamId](const FTeamGrid& Grid) { return Grid.TeamId == TeamId; });
+
+		if (!TeamGrid)
+		{
+			TeamGrid = &TeamGrids.AddDefaulted_GetRef();
+			TeamGrid->TeamId = TeamId;
+		}
+
+		FEntry& Entry = TeamGrid->Entries.AddDefaulted_GetRef();
+		Entry.Character = Character;
+		Entry.Location = Character->GetActorLocation();
+		Character->GetCapsuleComponent()->GetScaledCapsuleSize(Entry.CapsuleRadius, Entry.CapsuleHalfHeight);
+		Entry.CellKey = GetCellKey(Entry.Location);
+
+		MaxCapsuleRadius = FMath::Max(MaxCapsuleRadius, Entry.CapsuleRadius);
+	}
+
+	for (FTeamGrid& TeamGrid : TeamGrids)
+	{
+		// Sorting by cell makes each cell one range of entries
+		TeamGrid.Entries.Sort([](const FEntry& A, const FEntry& B) { return A.CellKey < B.CellKey; });
+
+		int32 RangeStart = 0;
+		for (int32 Index = 1; Index <= TeamGrid.Entries.Num(); Index++)
+		{
+			if (Index == TeamGrid.Entries.Num() || TeamGrid.Entries[Index].CellKey != TeamGrid.Entries[RangeStart].CellKey)
+			{
+				TeamGrid.Cells.Add(TeamGrid.Entries[RangeStart].CellKey, TPair<int32, int32>(RangeStart, Index - RangeStart));
+				RangeStart = Index;
+			}
+		}
+	}
+}
+
+void URPGCharacterSpatialHash::ForEachCandidate(const FVector& BoundsMin, const FVector& BoundsMax, const FRPGSpatialQueryFilter& Filter, TFunctionRef<void(const FEntry&)> Visitor)
+{
+	UpdateGrids();
+
+	const int32 MinX = FMath::FloorToInt((BoundsMin.X - MaxCapsuleRadius) / BuiltCellSize);
+	const int32 MinY = FMath::FloorToInt((BoundsMin.Y - MaxCapsuleRadius) / BuiltCellSize);
+	const int32 MaxX = FMath::FloorToInt((BoundsMax.X + MaxCapsuleRadius) / BuiltCellSize);
+	const int32 MaxY = FMath::FloorToInt((BoundsMax.Y + MaxCapsuleRadius) / BuiltCellSize);
+
+	for (const FTeamGrid& TeamGrid : TeamGrids)
+	{
+		const bool bSameTeam = TeamGrid.TeamId == Filter.TeamId;
+
+		if (TeamGrid.Entries.Num() == 0 || (Filter.Team == ERPGTargetTeam::Hostile && bSameTeam) || (Filter.Team == ERPGTargetTeam::Friendly && !bSameTeam))
+		{
+			continue;
+		}
+
+		for (int32 CellX = MinX; CellX <= MaxX; CellX++)
+		{
+			for (int32 CellY = MinY; CellY <= MaxY; CellY++)
+			{
+				const TPair<int32, int32>* Cell = TeamGrid.Cells.Find(GetCellKey(CellX, CellY));
+
+				if (!Cell)
+				{
+					continue;
+				}
+
+				for (int32 Index = Cell->Key; Index < Cell->Key + Cell->Value; Index++)
+				{
+					const FEntry& Entry = TeamGrid.Entries[Index];
+
+					if (Entry.Character != Filter.IgnoredCharacter)
+					{
+						Visitor(Entry);
+					}
+				}
+			}
+		}
+	}
+}
+
+void URPGCharacterSpatialHash::QuerySphere(const FVector& Center, float Radius, const FRPGSpatialQueryFilter& Filter, TArray<ARPGCharacterBase*>& OutCharacters)
+{
+	const FVector Extent(Radius);
+
+	ForEachCandidate(Center - Extent, Center + Extent, Filter, [&](const FEntry& Entry)
+	{
+		FVector SegmentStart, SegmentEnd;
+		Entry.GetSegment(SegmentStart, SegmentEnd);
+
+		const float TouchDistance = Radius + Entry.CapsuleRadius;
+		if (FMath::PointDistToSegmentSquared(Center, SegmentStart, SegmentEnd) <= FMath::Square(TouchDistance))
+		{
+			OutCharacters.Add(Entry.Character);
+		}
+	});
+}
+
+void URPGCharacterSpatialHash::QueryCone(const FVector& Origin, const FVector& Direction, float Range, float HalfAngleDegrees, const FRPGSpatialQueryFilter& Filter, TArray<ARPGCharacterBase*>& OutCharacters)
+{
+	const FVector Extent(Range);
+	const float HalfAngle = FMath::DegreesToRadians(FMath::Clamp(HalfAngleDegrees, 0.0f, 180.0f));
+
+	ForEachCandidate(Origin - Extent, Origin + Extent, Filter, [&](const FEntry& Entry)
+	{
+		FVector SegmentStart, SegmentEnd;
+		Entry.GetSegment(SegmentStart, SegmentEnd);
+
+		const FVector ToCapsule = FMath::ClosestPointOnSegment(Origin, SegmentStart, SegmentEnd) - Origin;
+		const float Distance = ToCapsule.Size();
+
+		if (Distance > Range + Entry.CapsuleRadius)
+		{
+			return;
+		}
+
+		if (Distance <= Entry.CapsuleRadius)
+		{
+			// The origin is inside the capsule
+			OutCharacters.Add(Entry.Character);
+			return;
+		}
+
+		// Widen the cone by the angle the capsule covers at this distance
+		const float CapsuleAngle = FMath::Asin(Entry.CapsuleRadius / Distance);
+		const float AngleToCapsule = FMath::Acos(FMath::Clamp(FVector::DotProduct(Direction, ToCapsule / Distance), -1.0f, 1.0f));
+
+		if (AngleToCapsule <= HalfAngle + CapsuleAngle)
+		{
+			OutCharacters.Add(Entry.Character);
+		}
+	});
+}
+
+void URPGCharacterSpatialHash::QueryCapsuleSweep(const FVector& Start, const FVector& End, float SweepRadius, const FRPGSpatialQueryFilter& Filter, TArray<ARPGCharacterBase*>& OutCharacters)
+{
+	const FVector Extent(SweepRadius);
+
+	ForEachCandidate(Start.ComponentMin(End) - Extent, Start.ComponentMax(End) + Extent, Filter, [&](const FEntry& Entry)
+	{
+		FVector SegmentStart, SegmentEnd;
+		Entry.GetSegment(SegmentStart, SegmentEnd);
+
+		FVector SweepPoint, CapsulePoint;
+		FMath::SegmentDistToSegmentSafe(Start, End, SegmentStart, SegmentEnd, SweepPoint, CapsulePoint);
+
+		if (FVector::DistSquared(SweepPoint, CapsulePoint) <= FMath::Square(SweepRadius + Entry.CapsuleRadius))
+		{
+			OutCharacters.Add(Entry.Character);
+		}
+	});
+}
+
+#if !UE_BUILD_SHIPPING
+
+static void BenchmarkSpatialHash(const TArray<FString>& Args, UWorld* World)
+{
+	if (Args.Num() < 1)
+	{
+		UE_LOG(LogActionRPG, Display, TEXT("Usage: RPG.SpatialHash.Benchmark <CharacterClassPath> [NumQueries] [Radius]"));
+		return;
+	}
+
+	URPGCharacterSpatialHash* SpatialHash = World ? World->GetSubsystem<URPGCharacterSpatialHash>() : nullptr;
+	UClass* CharacterClass = LoadClass<ARPGCharacterBase>(nullptr, *Args[0]);
+
+	if (!SpatialHash || !CharacterClass)
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("Spatial hash benchmark: needs a game world and a character class"));
+		return;
+	}
+
+	const int32 NumQueries = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 1000;
+	const float Radius = Args.Num() > 2 ? FMath::Max(1.0f, FCString::Atof(*Args[2])) : 500.0f;
+	const int32 CharacterCounts[] = { 50, 200, 1000 };
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	for (int32 NumCharacters : CharacterCounts)
+	{
+		// Same density at every count, so a query finds about the same number of characters
+		const float Spacing = 300.0f;
+		const int32 RowLength = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumCharacters)));
+		const float AreaSize = RowLength * Spacing;
+
+		TArray<ARPGCharacterBase*> SpawnedCharacters;
+		for (int32 Index = 0; Index < NumCharacters; Index++)
+		{
+			const FVector Location(Spacing * (Index % RowLength), Spacing * (Index / RowLength), 100.0f);
+			ARPGCharacterBase* Character = World->SpawnActor<ARPGCharacterBase>(CharacterClass, Location, FRotator::ZeroRotator, SpawnParameters);
+
+			if (Character)
+			{
+				SpawnedCharacters.Add(Character);
+			}
+		}
+
+		FRandomStream Random(1234);
+		TArray<FVector> Centers;
+		Centers.SetNumUninitialized(NumQueries);
+		for (FVector& Center : Centers)
+		{
+			Center = FVector(Random.FRandRange(0.0f, AreaSize), Random.FRandRange(0.0f, AreaSize), 100.0f);
+		}
+
+		// The current approach, a pawn overlap filtered down to characters
+		TArray<FOverlapResult> Overlaps;
+		TArray<ARPGCharacterBase*> Found;
+		int32 OverlapFound = 0;
+		const FCollisionObjectQueryParams ObjectParams(ECC_Pawn);
+		const FCollisionShape Sphere = FCollisionShape::MakeSphere(Radius);
+
+		double StartTime = FPlatformTime::Seconds();
+		for (const FVector& Center : Centers)
+		{
+			Overlaps.Reset();
+			Found.Reset();
+			World->OverlapMultiByObjectType(Overlaps, Center, FQuat::Identity, ObjectParams, Sphere);
+
+			for (const FOverlapResult& Overlap : Overlaps)
+			{
+				ARPGCharacterBase* Character = Cast<ARPGCharacterBase>(Overlap.GetActor());
+				if (Character && Character->GetHealth() > 0.0f)
+				{
+					Found.AddUnique(Character);
+				}
+			}
+			OverlapFound += Found.Num();
+		}
+		const double OverlapSeconds = FPlatformTime::Seconds() - StartTime;
+
+		// The first query of the frame pays for building the grid, so it is measured as well
+		int32 GridFound = 0;
+		StartTime = FPlatformTime::Seconds();
+		for (const FVector& Center : Centers)
+		{
+			Found.Reset();
+			SpatialHash->QuerySphere(Center, Radius, FRPGSpatialQueryFilter(), Found);
+			GridFound += Found.Num();
+		}
+		const double GridSeconds = FPlatformTime::Seconds() - StartTime;
+
+		UE_LOG(LogActionRPG, Display, TEXT("Spatial hash benchmark: %4d characters, %d queries of radius %.0f, overlap %.2f us/query (%d found), grid %.2f us/query (%d found)"),
+			SpawnedCharacters.Num(), NumQueries, Radius, OverlapSeconds * 1.0e6 / NumQueries, OverlapFound, GridSeconds * 1.0e6 / NumQueries, GridFound);
+
+		for (ARPGCharacterBase* Character : SpawnedCharacters)
+		{
+			AController* Controller = Character->GetController();
+			Character->Destroy();
+
+			if (Controller)
+			{
+				Controller->Destroy();
+			}
+		}
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkSpatialHashCommand(
+	TEXT("RPG.SpatialHash.Benchmark"),
+	TEXT("Compares sphere queries through physics overlaps and through the character spatial hash at 50, 200 and 1000 characters. Arguments are the character class path, the number of queries (1000) and the radius (500)"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkSpatialHash));
+
+#endif
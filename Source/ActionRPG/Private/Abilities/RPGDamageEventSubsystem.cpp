@@ -0,0 +1,136 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Abilities/RPGDamageEventSubsystem.h"
+#include "Abilities/RPGAttributeSet.h"
+#include "RPGCharacterBase.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static int32 GRPGDeferDamageEvents = 1;
+static FAutoConsoleVariableRef CVarRPGDeferDamageEvents(
+	TEXT("RPG.Damage.DeferEvents"),
+	GRPGDeferDamageEvents,
+	TEXT("If non zero, damage and health change callbacks are queued and dispatched once per frame after actors tick"));
+
+/** Callbacks can cause more damage, after this many passes the rest waits for the next frame */
+static const int32 MaxDispatchPasses = 4;
+
+const FHitResult URPGDamageEventSubsystem::EmptyHitResult;
+
+void URPGDamageEventSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &URPGDamageEventSubsystem::HandlePostActorTick);
+}
+
+void URPGDamageEventSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	PostActorTickHandle.Reset();
+
+	// The world is going away, so there is nobody left to tell
+	PendingEvents.Reset();
+	DispatchingEvents.Reset();
+
+	Super::Deinitialize();
+}
+
+URPGDamageEventSubsystem* URPGDamageEventSubsystem::GetForDeferredEvents(const ARPGCharacterBase* Character)
+{
+	if (!GRPGDeferDamageEvents || !Character || Character->bHandleDamageImmediately)
+	{
+		return nullptr;
+	}
+
+	UWorld* World = Character->GetWorld();
+	return World ? World->GetSubsystem<URPGDamageEventSubsystem>() : nullptr;
+}
+
+void URPGDamageEventSubsystem::QueueDamage(ARPGCharacterBase* Target, float DamageAmount, const FGameplayEffectContextHandle& EffectContext, const FGameplayTagContainer& DamageTags)
+{
+	FDamageEvent& DamageEvent = PendingEvents.DamageEvents.AddDefaulted_GetRef();
+	DamageEvent.Target = Target;
+	DamageEvent.EffectContext = EffectContext;
+	DamageEvent.DamageAmount = DamageAmount;
+	DamageEvent.TagsIndex = AddEventTags(DamageTags);
+}
+
+void URPGDamageEventSubsystem::QueueHealthChange(ARPGCharacterBase* Target, float DeltaValue, const FGameplayTagContainer& EventTags)
+{
+	const int32 TagsIndex = AddEventTags(EventTags);
+	const int32* FoundIndex = PendingEvents.HealthChangeIndices.Find(Target);
+
+	if (FoundIndex)
+	{
+		FHealthChange& HealthChange = PendingEvents.HealthChanges[*FoundIndex];
+		HealthChange.DeltaValue += DeltaValue;
+		HealthChange.TagsIndex = TagsIndex;
+		return;
+	}
+
+	PendingEvents.HealthChangeIndices.Add(Target, PendingEvents.HealthChanges.Num());
+
+	FHealthChange& HealthChange = PendingEvents.HealthChanges.AddDefaulted_GetRef();
+	HealthChange.Target = Target;
+	HealthChange.DeltaValue = DeltaValue;
+	HealthChange.TagsIndex = TagsIndex;
+}
+
+void URPGDamageEventSubsystem::FlushEvents()
+{
+	for (int32 Pass = 0; Pass < MaxDispatchPasses && !PendingEvents.IsEmpty(); Pass++)
+	{
+		// Callbacks queue into the pending queue, which is empty again after the swap
+		Swap(PendingEvents, DispatchingEvents);
+		PendingEvents.Reset();
+
+		for (const FDamageEvent& DamageEvent : DispatchingEvents.DamageEvents)
+		{
+			ARPGCharacterBase* TargetCharacter = DamageEvent.Target.Get();
+
+			if (TargetCharacter)
+			{
+				ARPGCharacterBase* SourceCharacter = nullptr;
+				AActor* SourceActor = nullptr;
+				URPGAttributeSet::GetDamageSource(DamageEvent.EffectContext, SourceCharacter, SourceActor);
+
+				const FHitResult* HitResult = DamageEvent.EffectContext.GetHitResult();
+				const FHitResult& Hit = HitResult ? *HitResult : EmptyHitResult;
+				TargetCharacter->HandleDamage(DamageEvent.DamageAmount, Hit, DispatchingEvents.EventTags[DamageEvent.TagsIndex], SourceCharacter, SourceActor);
+			}
+		}
+
+		for (const FHealthChange& HealthChange : DispatchingEvents.HealthChanges)
+		{
+			ARPGCharacterBase* TargetCharacter = HealthChange.Target.Get();
+
+			if (TargetCharacter)
+			{
+				TargetCharacter->HandleHealthChanged(HealthChange.DeltaValue, DispatchingEvents.EventTags[HealthChange.TagsIndex]);
+			}
+		}
+
+		DispatchingEvents.Reset();
+	}
+}
+
+int32 URPGDamageEventSubsystem::AddEventTags(const FGameplayTagContainer& Tags)
+{
+	TArray<FGameplayTagContainer>& EventTags = PendingEvents.EventTags;
+
+	// Hits from one area effect arrive together with the same source tags
+	if (EventTags.Num() > 0 && EventTags.Last() == Tags)
+	{
+		return EventTags.Num() - 1;
+	}
+	return EventTags.Add(Tags);
+}
+
+void URPGDamageEventSubsystem::HandlePostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World == GetWorld())
+	{
+		FlushEvents();
+	}
+}
@@ -2,7 +2,19 @@
 
 #include "Abilities/RPGDamageExecution.h"
 #include "Abilities/RPGAttributeSet.h"
+#include "Abilities/RPGAbilityTypes.h"
+#include "RPGCharacterBase.h"
 #include "AbilitySystemComponent.h"
+#include "GameplayEffect.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "HAL/IConsoleManager.h"
+
+static int32 GRPGDamageCacheSourceMagnitudes = 1;
+static FAutoConsoleVariableRef CVarRPGDamageCacheSourceMagnitudes(
+	TEXT("RPG.Damage.CacheSourceMagnitudes"),
+	GRPGDamageCacheSourceMagnitudes,
+	TEXT("If non zero, the source AttackPower and Damage are evaluated once when a damage spec is applied to several targets at once"));
 
 struct RPGDamageStatics
 {
@@ -31,6 +43,120 @@ static const RPGDamageStatics& DamageStatics()
 	return DmgStatics;
 }
 
+/** Returns true if a scoped modifier evaluates to the same magnitude for every target, like scalable float and set by caller magnitudes do */
+static bool IsScopedModifierSameForAllTargets(const FGameplayEffectExecutionScopedModifierInfo& ScopedModifier)
+{
+	if (!ScopedModifier.SourceTags.IsEmpty() || !ScopedModifier.TargetTags.IsEmpty())
+	{
+		return false;
+	}
+
+	switch (ScopedModifier.ModifierMagnitude.GetMagnitudeCalculationType())
+	{
+	case EGameplayEffectMagnitudeCalculation::ScalableFloat:
+	case EGameplayEffectMagnitudeCalculation::SetByCaller:
+		return true;
+
+	case EGameplayEffectMagnitudeCalculation::AttributeBased:
+	{
+		TArray<FGameplayEffectAttributeCaptureDefinition> CaptureDefinitions;
+		ScopedModifier.ModifierMagnitude.GetAttributeCaptureDefinitions(CaptureDefinitions);
+
+		for (const FGameplayEffectAttributeCaptureDefinition& CaptureDefinition : CaptureDefinitions)
+		{
+			if (CaptureDefinition.AttributeSource == EGameplayEffectAttributeCaptureSource::Target)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	default:
+		// Custom calculation classes can read anything from the target
+		return false;
+	}
+}
+
+/** Innermost open source scope, scopes are only opened on the game thread */
+static FRPGDamageSourceScope* GRPGDamageSourceScope = nullptr;
+
+FRPGDamageSourceScope::FRPGDamageSourceScope(const FGameplayEffectSpec& Spec)
+	: OuterScope(GRPGDamageSourceScope)
+	, EffectDef(Spec.Def)
+	, SourceComponent(Spec.GetContext().GetInstigatorAbilitySystemComponent())
+	, Level(Spec.GetLevel())
+	, bCanCache(Spec.Def != nullptr && IsInGameThread())
+	, bHasMagnitudes(false)
+	, AttackPower(0.0f)
+	, Damage(0.0f)
+{
+	if (bCanCache)
+	{
+		for (const FGameplayEffectExecutionDefinition& Execution : EffectDef->Executions)
+		{
+			if (Execution.CalculationClass && Execution.CalculationClass->IsChildOf(URPGDamageExecution::StaticClass()))
+			{
+				for (const FGameplayEffectExecutionScopedModifierInfo& ScopedModifier : Execution.CalculationModifiers)
+				{
+					if (!IsScopedModifierSameForAllTargets(ScopedModifier))
+					{
+						bCanCache = false;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	if (IsInGameThread())
+	{
+		GRPGDamageSourceScope = this;
+	}
+}
+
+FRPGDamageSourceScope::~FRPGDamageSourceScope()
+{
+	if (GRPGDamageSourceScope == this)
+	{
+		GRPGDamageSourceScope = OuterScope;
+	}
+}
+
+FRPGDamageSourceScope* FRPGDamageSourceScope::Find(const FGameplayEffectSpec& Spec, const UAbilitySystemComponent* InSourceComponent)
+{
+	FRPGDamageSourceScope* Scope = IsInGameThread() ? GRPGDamageSourceScope : nullptr;
+
+	// Only the innermost scope is used, an effect applied from inside it belongs to a different application
+	if (GRPGDamageCacheSourceMagnitudes && Scope && Scope->bCanCache && Scope->EffectDef == Spec.Def && Scope->Level == Spec.GetLevel() && Scope->SourceComponent == InSourceComponent)
+	{
+		return Scope;
+	}
+	return nullptr;
+}
+
+bool FRPGDamageSourceScope::GetMagnitudes(const FGameplayTagContainer* InSourceTags, const FGameplayTagContainer* InTargetTags, float& OutAttackPower, float& OutDamage) const
+{
+	if (bHasMagnitudes
+		&& SourceTags == (InSourceTags ? *InSourceTags : FGameplayTagContainer::EmptyContainer)
+		&& TargetTags == (InTargetTags ? *InTargetTags : FGameplayTagContainer::EmptyContainer))
+	{
+		OutAttackPower = AttackPower;
+		OutDamage = Damage;
+		return true;
+	}
+	return false;
+}
+
+void FRPGDamageSourceScope::SetMagnitudes(const FGameplayTagContainer* InSourceTags, const FGameplayTagContainer* InTargetTags, float InAttackPower, float InDamage)
+{
+	SourceTags = InSourceTags ? *InSourceTags : FGameplayTagContainer::EmptyContainer;
+	TargetTags = InTargetTags ? *InTargetTags : FGameplayTagContainer::EmptyContainer;
+	AttackPower = InAttackPower;
+	Damage = InDamage;
+	bHasMagnitudes = true;
+}
+
 URPGDamageExecution::URPGDamageExecution()
 {
 	RelevantAttributesToCapture.Add(DamageStatics().DefensePowerDef);
@@ -63,20 +189,141 @@ void URPGDamageExecution::Execute_Implementation(const FGameplayEffectCustomExec
 
 	float DefensePower = 0.f;
 	ExecutionParams.AttemptCalculateCapturedAttributeMagnitude(DamageStatics().DefensePowerDef, EvaluationParameters, DefensePower);
+
+	float AttackPower = 0.f;
+	float Damage = 0.f;
+
+	// Both source attributes are snapshots, so every target of one application gets the same values
+	FRPGDamageSourceScope* SourceScope = FRPGDamageSourceScope::Find(Spec, SourceAbilitySystemComponent);
+	if (!SourceScope || !SourceScope->GetMagnitudes(SourceTags, TargetTags, AttackPower, Damage))
+	{
+		ExecutionParams.AttemptCalculateCapturedAttributeMagnitude(DamageStatics().AttackPowerDef, EvaluationParameters, AttackPower);
+		ExecutionParams.AttemptCalculateCapturedAttributeMagnitude(DamageStatics().DamageDef, EvaluationParameters, Damage);
+
+		if (SourceScope)
+		{
+			SourceScope->SetMagnitudes(SourceTags, TargetTags, AttackPower, Damage);
+		}
+	}
+
 	if (DefensePower == 0.0f)
 	{
 		DefensePower = 1.0f;
 	}
 
-	float AttackPower = 0.f;
-	ExecutionParams.AttemptCalculateCapturedAttributeMagnitude(DamageStatics().AttackPowerDef, EvaluationParameters, AttackPower);
-
-	float Damage = 0.f;
-	ExecutionParams.AttemptCalculateCapturedAttributeMagnitude(DamageStatics().DamageDef, EvaluationParameters, Damage);
-
 	float DamageDone = Damage * AttackPower / DefensePower;
 	if (DamageDone > 0.f)
 	{
 		OutExecutionOutput.AddOutputModifier(FGameplayModifierEvaluatedData(DamageStatics().DamageProperty, EGameplayModOp::Additive, DamageDone));
 	}
-}
\ No newline at end of file
+}
+
+#if !UE_BUILD_SHIPPING
+
+static void BenchmarkDamageApplication(const TArray<FString>& Args, UWorld* World)
+{
+	if (Args.Num() < 2)
+	{
+		UE_LOG(LogActionRPG, Display, TEXT("Usage: RPG.Damage.Benchmark <CharacterClassPath> <DamageEffectClassPath> [Iterations]"));
+		return;
+	}
+
+	UClass* CharacterClass = LoadClass<ARPGCharacterBase>(nullptr, *Args[0]);
+	UClass* EffectClass = LoadClass<UGameplayEffect>(nullptr, *Args[1]);
+
+	if (!World || World->GetNetMode() == NM_Client || !CharacterClass || !EffectClass)
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("Damage benchmark: needs a game world with authority, a character class and a gameplay effect class"));
+		return;
+	}
+
+	const int32 NumIterations = Args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Args[2])) : 100;
+	const int32 TargetCounts[] = { 1, 16, 64, 256 };
+	const int32 MaxTargets = 256;
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	// One source and a grid of targets, the source is the first character
+	TArray<ARPGCharacterBase*> Characters;
+	for (int32 Index = 0; Index <= MaxTargets; Index++)
+	{
+		const FVector Location(200.0f * (Index % 16), 200.0f * (Index / 16), 100.0f);
+		ARPGCharacterBase* Character = World->SpawnActor<ARPGCharacterBase>(CharacterClass, Location, FRotator::ZeroRotator, SpawnParameters);
+
+		if (Character && Character->GetAbilitySystemComponent())
+		{
+			Characters.Add(Character);
+		}
+	}
+
+	if (Characters.Num() > 1)
+	{
+		UAbilitySystemComponent* SourceComponent = Characters[0]->GetAbilitySystemComponent();
+		FGameplayEffectSpecHandle SpecHandle = SourceComponent->MakeOutgoingSpec(EffectClass, 1.0f, SourceComponent->MakeEffectContext());
+		const int32 OldCacheSourceMagnitudes = GRPGDamageCacheSourceMagnitudes;
+
+		for (int32 NumTargets : TargetCounts)
+		{
+			NumTargets = FMath::Min(NumTargets, Characters.Num() - 1);
+
+			// Same target data an area ability builds
+			TArray<FHitResult> HitResults;
+			for (int32 Index = 1; Index <= NumTargets; Index++)
+			{
+				HitResults.Emplace(Characters[Index], nullptr, Characters[Index]->GetActorLocation(), FVector::UpVector);
+			}
+
+			FRPGGameplayEffectContainerSpec ContainerSpec;
+			ContainerSpec.AddTargets(HitResults, TArray<AActor*>());
+
+			double Seconds[2] = { 0.0, 0.0 };
+			double DamageDealt[2] = { 0.0, 0.0 };
+
+			for (int32 CacheSourceMagnitudes = 0; CacheSourceMagnitudes < 2; CacheSourceMagnitudes++)
+			{
+				GRPGDamageCacheSourceMagnitudes = CacheSourceMagnitudes;
+
+				for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+				{
+					const double StartTime = FPlatformTime::Seconds();
+					ContainerSpec.ApplyEffectSpecToTargets(*SpecHandle.Data.Get());
+					Seconds[CacheSourceMagnitudes] += FPlatformTime::Seconds() - StartTime;
+
+					// Heal the targets outside of the timing so they survive every iteration
+					for (int32 Index = 1; Index <= NumTargets; Index++)
+					{
+						ARPGCharacterBase* Target = Characters[Index];
+						DamageDealt[CacheSourceMagnitudes] += Target->GetMaxHealth() - Target->GetHealth();
+						Target->GetAbilitySystemComponent()->SetNumericAttributeBase(URPGAttributeSet::GetHealthAttribute(), Target->GetMaxHealth());
+					}
+				}
+			}
+
+			const double NumApplications = static_cast<double>(NumIterations) * NumTargets;
+			UE_LOG(LogActionRPG, Display, TEXT("Damage benchmark: %3d targets, uncached %.2f us/target, cached %.2f us/target%s"),
+				NumTargets, Seconds[0] * 1.0e6 / NumApplications, Seconds[1] * 1.0e6 / NumApplications,
+				FMath::IsNearlyEqual(DamageDealt[0], DamageDealt[1], FMath::Abs(DamageDealt[0]) * 1.0e-6) ? TEXT("") : TEXT(" (damage differs!)"));
+		}
+
+		GRPGDamageCacheSourceMagnitudes = OldCacheSourceMagnitudes;
+	}
+
+	for (ARPGCharacterBase* Character : Characters)
+	{
+		AController* Controller = Character->GetController();
+		Character->Destroy();
+
+		if (Controller)
+		{
+			Controller->Destroy();
+		}
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkDamageApplicationCommand(
+	TEXT("RPG.Damage.Benchmark"),
+	TEXT("Applies a damage effect to 1, 16, 64 and 256 targets through the effect container path, with and without cached source magnitudes. Arguments are the character class path, the effect class path and the number of iterations (100)"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkDamageApplication));
+
+#endif
@@ -58,10 +58,15 @@ TArray<FActiveGameplayEffectHandle> URPGGameplayAbility::ApplyEffectContainerSpe
 {
 	TArray<FActiveGameplayEffectHandle> AllEffects;
 
-	// Iterate list of effect specs and apply them to their target data
+	// Iterate list of effect specs and apply them to their target data, with the same checks as K2_ApplyGameplayEffectSpecToTarget
 	for (const FGameplayEffectSpecHandle& SpecHandle : ContainerSpec.TargetGameplayEffectSpecs)
 	{
-		AllEffects.Append(K2_ApplyGameplayEffectSpecToTarget(SpecHandle, ContainerSpec.TargetData));
+		if (SpecHandle.IsValid() && HasAuthorityOrPredictionKey(CurrentActorInfo, &CurrentActivationInfo))
+		{
+			UAbilitySystemComponent* OwningASC = CurrentActorInfo->AbilitySystemComponent.Get();
+			TARGETLIST_SCOPE_LOCK(*OwningASC);
+			AllEffects.Append(ContainerSpec.ApplyEffectSpecToTargets(*SpecHandle.Data.Get(), OwningASC->GetPredictionKeyForNewAction()));
+		}
 	}
 	return AllEffects;
 }
@@ -26,4 +26,76 @@ void URPGTargetType_UseEventData::GetTargets_Implementation(ARPGCharacterBase* T
 		//OutActors.Add(const_cast<AActor*>(EventData.Target));
 		OutActors.Add(const_cast<AActor*>(ToRawPtr(EventData.Target)));
 	}
-}
\ No newline at end of file
+}
+
+URPGTargetType_Area::URPGTargetType_Area()
+	: OriginOffset(FVector::ZeroVector)
+	, TeamFilter(ERPGTargetTeam::Hostile)
+	, bIncludeSelf(false)
+{
+}
+
+void URPGTargetType_Area::GetTargets_Implementation(ARPGCharacterBase* TargetingCharacter, AActor* TargetingActor, FGameplayEventData EventData, TArray<FHitResult>& OutHitResults, TArray<AActor*>& OutActors) const
+{
+	AActor* OriginActor = TargetingActor ? TargetingActor : TargetingCharacter;
+	UWorld* World = OriginActor ? OriginActor->GetWorld() : nullptr;
+	URPGCharacterSpatialHash* SpatialHash = World ? World->GetSubsystem<URPGCharacterSpatialHash>() : nullptr;
+
+	if (!SpatialHash)
+	{
+		return;
+	}
+
+	FRPGSpatialQueryFilter Filter;
+	Filter.Team = TeamFilter;
+	Filter.IgnoredCharacter = bIncludeSelf ? nullptr : TargetingCharacter;
+
+	if (TargetingCharacter)
+	{
+		Filter.TeamId = FGenericTeamId::GetTeamIdentifier(TargetingCharacter);
+	}
+
+	const FTransform& OriginTransform = OriginActor->GetActorTransform();
+	const FVector Origin = OriginTransform.TransformPosition(OriginOffset);
+
+	TArray<ARPGCharacterBase*> FoundCharacters;
+	QueryCharacters(SpatialHash, Origin, OriginTransform.GetUnitAxis(EAxis::X), Filter, FoundCharacters);
+
+	OutActors.Reserve(OutActors.Num() + FoundCharacters.Num());
+	for (ARPGCharacterBase* Character : FoundCharacters)
+	{
+		OutActors.Add(Character);
+	}
+}
+
+URPGTargetType_Sphere::URPGTargetType_Sphere()
+	: Radius(300.0f)
+{
+}
+
+void URPGTargetType_Sphere::QueryCharacters(URPGCharacterSpatialHash* SpatialHash, const FVector& Origin, const FVector& Forward, const FRPGSpatialQueryFilter& Filter, TArray<ARPGCharacterBase*>& OutCharacters) const
+{
+	SpatialHash->QuerySphere(Origin, Radius, Filter, OutCharacters);
+}
+
+URPGTargetType_Cone::URPGTargetType_Cone()
+	: Range(500.0f)
+	, HalfAngleDegrees(45.0f)
+{
+}
+
+void URPGTargetType_Cone::QueryCharacters(URPGCharacterSpatialHash* SpatialHash, const FVector& Origin, const FVector& Forward, const FRPGSpatialQueryFilter& Filter, TArray<ARPGCharacterBase*>& OutCharacters) const
+{
+	SpatialHash->QueryCone(Origin, Forward, Range, HalfAngleDegrees, Filter, OutCharacters);
+}
+
+URPGTargetType_CapsuleSweep::URPGTargetType_CapsuleSweep()
+	: Distance(1000.0f)
+	, SweepRadius(50.0f)
+{
+}
+
+void URPGTargetType_CapsuleSweep::QueryCharacters(URPGCharacterSpatialHash* SpatialHash, const FVector& Origin, const FVector& Forward, const FRPGSpatialQueryFilter& Filter, TArray<ARPGCharacterBase*>& OutCharacters) const
+{
+	SpatialHash->QueryCapsuleSweep(Origin, Origin + Forward * Distance, SweepRadius, Filter, OutCharacters);
+}
@@ -16,9 +16,53 @@ FString URPGItem::GetIdentifierString() const
 	return GetPrimaryAssetId().ToString();
 }
 
+int32 URPGItem::GetRegistryIndex()
+{
+	if (ItemRegistryIndex != INDEX_NONE)
+	{
+		return ItemRegistryIndex;
+	}
+	return URPGAssetManager::Get().RegisterItem(this);
+}
+
 FPrimaryAssetId URPGItem::GetPrimaryAssetId() const
 {
 	// This is a DataAsset and not a blueprint so we can just use the raw FName
 	// For blueprints you need to handle stripping the _C suffix
 	return FPrimaryAssetId(ItemType, GetFName());
-}
\ No newline at end of file
+}
+
+#if WITH_EDITOR
+void URPGItem::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// Force the stats to be copied again
+	if (ItemRegistryIndex != INDEX_NONE && GEngine && GEngine->AssetManager)
+	{
+		ItemRegistryIndex = INDEX_NONE;
+		URPGAssetManager::Get().RegisterItem(this);
+	}
+}
+
+void URPGItem::PostLoad()
+{
+	Super::PostLoad();
+
+	if (SoftItemIcon.IsNull() && ItemIcon.GetResourceObject())
+	{
+		SoftItemIcon = ItemIcon.GetResourceObject();
+	}
+}
+
+void URPGItem::PreSave(FObjectPreSaveContext ObjectSaveContext)
+{
+	Super::PreSave(ObjectSaveContext);
+
+	if (GetDefault<URPGAssetManager>()->bStreamItemIcons && !SoftItemIcon.IsNull())
+	{
+		// Brush settings stay, the icon cache fills the texture back in
+		ItemIcon.SetResourceObject(nullptr);
+	}
+}
+#endif
\ No newline at end of file
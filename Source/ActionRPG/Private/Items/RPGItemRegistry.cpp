@@ -0,0 +1,52 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Items/RPGItemRegistry.h"
+#include "Items/RPGItem.h"
+#include "Abilities/RPGGameplayAbility.h"
+
+void FRPGItemRegistry::Reset()
+{
+	IndexById.Reset();
+	AssetIds.Reset();
+	ItemTypes.Reset();
+	NativeItemTypes.Reset();
+	MaxCounts.Reset();
+	MaxLevels.Reset();
+	AbilityLevels.Reset();
+	GrantedAbilities.Reset();
+	StatsSet.Reset();
+}
+
+int32 FRPGItemRegistry::AddItem(const FPrimaryAssetId& ItemId)
+{
+	const int32* FoundIndex = IndexById.Find(ItemId);
+	if (FoundIndex)
+	{
+		return *FoundIndex;
+	}
+
+	const int32 Index = AssetIds.Add(ItemId);
+	ItemTypes.Add(ItemId.PrimaryAssetType);
+	NativeItemTypes.Add(RPGItemTypes::FromAssetType(ItemId.PrimaryAssetType));
+	MaxCounts.Add(1);
+	MaxLevels.Add(1);
+	AbilityLevels.Add(1);
+	GrantedAbilities.Add(nullptr);
+	StatsSet.Add(false);
+
+	IndexById.Add(ItemId, Index);
+	return Index;
+}
+
+void FRPGItemRegistry::SetItemStats(int32 Index, const URPGItem* Item)
+{
+	check(IsValidIndex(Index) && Item);
+
+	ItemTypes[Index] = Item->ItemType;
+	NativeItemTypes[Index] = RPGItemTypes::FromAssetType(Item->ItemType);
+	MaxCounts[Index] = Item->MaxCount;
+	MaxLevels[Index] = Item->MaxLevel;
+	AbilityLevels[Index] = Item->AbilityLevel;
+	GrantedAbilities[Index] = Item->GrantedAbility;
+	StatsSet[Index] = true;
+}
@@ -2,12 +2,31 @@
 
 #include "RPGAssetManager.h"
 #include "Items/RPGItem.h"
+#include "RPGCharacterBase.h"
+#include "RPGPlayerControllerBase.h"
 #include "AbilitySystemGlobals.h"
+#include "ActionRPGLoadingScreen.h"
+#include "Engine/World.h"
 
-const FPrimaryAssetType	URPGAssetManager::PotionItemType = TEXT("Potion");
-const FPrimaryAssetType	URPGAssetManager::SkillItemType = TEXT("Skill");
-const FPrimaryAssetType	URPGAssetManager::TokenItemType = TEXT("Token");
-const FPrimaryAssetType	URPGAssetManager::WeaponItemType = TEXT("Weapon");
+const FPrimaryAssetType	URPGAssetManager::PotionItemType = RPGItemTypes::GetName(ERPGItemType::Potion);
+const FPrimaryAssetType	URPGAssetManager::SkillItemType = RPGItemTypes::GetName(ERPGItemType::Skill);
+const FPrimaryAssetType	URPGAssetManager::TokenItemType = RPGItemTypes::GetName(ERPGItemType::Token);
+const FPrimaryAssetType	URPGAssetManager::WeaponItemType = RPGItemTypes::GetName(ERPGItemType::Weapon);
+
+URPGAssetManager::URPGAssetManager()
+	: ItemCacheHits(0)
+	, ItemCacheMisses(0)
+	, ItemLoadSeconds(0.0)
+	, ItemCacheWarmStartTime(0.0)
+	, bStreamItemIcons(false)
+	, ItemIconBudgetKB(32 * 1024)
+	, ItemIconUseCounter(0)
+	, ItemIconHits(0)
+	, ItemIconMisses(0)
+	, ItemIconEvictions(0)
+	, ItemIconResidentBytes(0)
+{
+}
 
 URPGAssetManager& URPGAssetManager::Get()
 {
@@ -29,20 +48,566 @@ void URPGAssetManager::StartInitialLoading()
 	Super::StartInitialLoading();
 
 	UAbilitySystemGlobals::Get().InitGlobalData();
+
+	if (!IsRunningCommandlet())
+	{
+		// Servers and the editor resolve items through ForceLoadItem too, so the cache is warmed everywhere but in commandlets.
+		// In the editor the asset registry may still be scanning, so wait for it
+		CallOrRegister_OnCompletedInitialScan(FSimpleMulticastDelegate::FDelegate::CreateUObject(this, &URPGAssetManager::WarmItemCache));
+
+		// The bundle preload reports to the loading screen, which only game clients have
+		if (!GIsEditor && !IsRunningDedicatedServer())
+		{
+			CallOrRegister_OnCompletedInitialScan(FSimpleMulticastDelegate::FDelegate::CreateUObject(this, &URPGAssetManager::PreloadItems));
+		}
+	}
 }
 
 
 URPGItem* URPGAssetManager::ForceLoadItem(const FPrimaryAssetId& PrimaryAssetId, bool bLogWarning)
-{	
+{
+	URPGItem** CachedItem = ItemCache.Find(PrimaryAssetId);
+
+	// An item can be invalid if it was deleted or reloaded in the editor
+	if (CachedItem && IsValid(*CachedItem))
+	{
+		ItemCacheHits++;
+		return *CachedItem;
+	}
+
+	ItemCacheMisses++;
+	const double StartTime = FPlatformTime::Seconds();
+
 	FSoftObjectPath ItemPath = GetPrimaryAssetPath(PrimaryAssetId);
 
 	// This does a synchronous load and may hitch
 	URPGItem* LoadedItem = Cast<URPGItem>(ItemPath.TryLoad());
 
-	if (bLogWarning && LoadedItem == nullptr)
+	ItemLoadSeconds += FPlatformTime::Seconds() - StartTime;
+
+	if (LoadedItem)
+	{
+		CacheItem(PrimaryAssetId, LoadedItem);
+	}
+	else if (bLogWarning)
 	{
 		UE_LOG(LogActionRPG, Warning, TEXT("Failed to load item for identifier %s!"), *PrimaryAssetId.ToString());
 	}
 
 	return LoadedItem;
-}
\ No newline at end of file
+}
+
+void URPGAssetManager::PostInitialAssetScan()
+{
+	Super::PostInitialAssetScan();
+
+	static const FPrimaryAssetType ItemTypes[] = { PotionItemType, SkillItemType, TokenItemType, WeaponItemType };
+
+	// Sorted so ids come out the same on every run with the same content
+	TArray<FPrimaryAssetId> ItemIds;
+	for (const FPrimaryAssetType& ItemType : ItemTypes)
+	{
+		GetPrimaryAssetIdList(ItemType, ItemIds);
+	}
+	ItemIds.Sort([](const FPrimaryAssetId& A, const FPrimaryAssetId& B) { return A.ToString() < B.ToString(); });
+
+	for (const FPrimaryAssetId& ItemId : ItemIds)
+	{
+		ItemRegistry.AddItem(ItemId);
+	}
+}
+
+int32 URPGAssetManager::RegisterItem(URPGItem* Item)
+{
+	if (!Item)
+	{
+		return INDEX_NONE;
+	}
+
+	if (!ItemRegistry.HasStats(Item->ItemRegistryIndex))
+	{
+		Item->ItemRegistryIndex = ItemRegistry.AddItem(Item->GetPrimaryAssetId());
+		ItemRegistry.SetItemStats(Item->ItemRegistryIndex, Item);
+	}
+	return Item->ItemRegistryIndex;
+}
+
+void URPGAssetManager::CacheItem(const FPrimaryAssetId& ItemId, URPGItem* Item)
+{
+	ItemCache.Add(ItemId, Item);
+	RegisterItem(Item);
+}
+
+void URPGAssetManager::RequestItemIcon(URPGItem* Item, const FOnItemIconLoaded& Delegate)
+{
+	if (!Item)
+	{
+		return;
+	}
+
+	const FSoftObjectPath IconPath = Item->SoftItemIcon.ToSoftObjectPath();
+	if (IconPath.IsNull())
+	{
+		// Not migrated, the brush holds the texture itself
+		Delegate.ExecuteIfBound(Item, Item->ItemIcon);
+		return;
+	}
+
+	FItemIconEntry& Entry = ItemIcons.FindOrAdd(IconPath);
+	Entry.LastUse = ++ItemIconUseCounter;
+
+	if (Entry.SizeBytes > 0)
+	{
+		ItemIconHits++;
+		Delegate.ExecuteIfBound(Item, MakeItemIconBrush(Item, IconPath.ResolveObject()));
+		return;
+	}
+
+	FItemIconRequest& Request = Entry.Requests.AddDefaulted_GetRef();
+	Request.Item = Item;
+	Request.Delegate = Delegate;
+
+	if (!Entry.Handle.IsValid())
+	{
+		ItemIconMisses++;
+
+		// The callback can run inside RequestAsyncLoad if the texture is already in memory, so it looks the entry up again
+		TSharedPtr<FStreamableHandle> Handle = GetStreamableManager().RequestAsyncLoad(IconPath, FStreamableDelegate::CreateUObject(this, &URPGAssetManager::HandleItemIconLoaded, IconPath));
+
+		FItemIconEntry* FoundEntry = ItemIcons.Find(IconPath);
+		if (FoundEntry)
+		{
+			FoundEntry->Handle = Handle;
+		}
+	}
+}
+
+void URPGAssetManager::HandleItemIconLoaded(FSoftObjectPath IconPath)
+{
+	FItemIconEntry* Entry = ItemIcons.Find(IconPath);
+	if (!Entry)
+	{
+		return;
+	}
+
+	UObject* IconObject = IconPath.ResolveObject();
+	if (IconObject && Entry->SizeBytes == 0)
+	{
+		Entry->SizeBytes = FMath::Max<int64>(1, IconObject->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal));
+		ItemIconResidentBytes += Entry->SizeBytes;
+	}
+
+	// Callbacks can request more icons, which may move the entry
+	TArray<FItemIconRequest> Requests = MoveTemp(Entry->Requests);
+	Entry->Requests.Reset();
+
+	for (const FItemIconRequest& Request : Requests)
+	{
+		URPGItem* Item = Request.Item.Get();
+
+		if (Item)
+		{
+			Request.Delegate.ExecuteIfBound(Item, MakeItemIconBrush(Item, IconObject));
+		}
+	}
+
+	if (!IconObject)
+	{
+		// Failed to load, let the next request try again
+		UE_LOG(LogActionRPG, Warning, TEXT("Failed to load item icon %s!"), *IconPath.ToString());
+		ItemIcons.Remove(IconPath);
+		return;
+	}
+
+	TrimItemIcons(IconPath);
+}
+
+void URPGAssetManager::TrimItemIcons(const FSoftObjectPath& KeepPath)
+{
+	const int64 BudgetBytes = (int64)ItemIconBudgetKB * 1024;
+
+	while (ItemIconResidentBytes > BudgetBytes)
+	{
+		// Only loaded icons nobody is waiting on can go, a linear scan is fine for the number of icons a game has
+		const FSoftObjectPath* OldestPath = nullptr;
+		uint64 OldestUse = MAX_uint64;
+
+		for (const TPair<FSoftObjectPath, FItemIconEntry>& Pair : ItemIcons)
+		{
+			if (Pair.Value.SizeBytes > 0 && Pair.Value.Requests.Num() == 0 && Pair.Value.LastUse < OldestUse && Pair.Key != KeepPath)
+			{
+				OldestPath = &Pair.Key;
+				OldestUse = Pair.Value.LastUse;
+			}
+		}
+
+		if (!OldestPath)
+		{
+			break;
+		}
+
+		const FSoftObjectPath EvictedPath = *OldestPath;
+		FItemIconEntry& Evicted = ItemIcons[EvictedPath];
+		if (Evicted.Handle.IsValid())
+		{
+			Evicted.Handle->ReleaseHandle();
+		}
+		ItemIconResidentBytes -= Evicted.SizeBytes;
+		ItemIconEvictions++;
+
+		ItemIcons.Remove(EvictedPath);
+	}
+}
+
+FSlateBrush URPGAssetManager::MakeItemIconBrush(const URPGItem* Item, UObject* IconObject)
+{
+	// Keep the size, tint and draw settings from the item
+	FSlateBrush Brush = Item->ItemIcon;
+	if (IconObject)
+	{
+		Brush.SetResourceObject(IconObject);
+	}
+	return Brush;
+}
+
+void URPGAssetManager::WarmItemCache()
+{
+	static const FPrimaryAssetType ItemTypes[] = { PotionItemType, SkillItemType, TokenItemType, WeaponItemType };
+
+	TArray<FPrimaryAssetId> ItemIds;
+	for (const FPrimaryAssetType& ItemType : ItemTypes)
+	{
+		GetPrimaryAssetIdList(ItemType, ItemIds);
+	}
+
+	if (ItemIds.Num() == 0)
+	{
+		return;
+	}
+
+	ItemCacheWarmStartTime = FPlatformTime::Seconds();
+
+	// No bundles, only the items themselves are needed to serve ForceLoadItem
+	TSharedPtr<FStreamableHandle> WarmHandle = LoadPrimaryAssets(ItemIds, TArray<FName>(), FStreamableDelegate::CreateUObject(this, &URPGAssetManager::HandleItemCacheWarmed, ItemIds));
+	if (!WarmHandle.IsValid())
+	{
+		// Everything was already loaded, the delegate is not called in that case
+		HandleItemCacheWarmed(ItemIds);
+	}
+}
+
+void URPGAssetManager::HandleItemCacheWarmed(TArray<FPrimaryAssetId> ItemIds)
+{
+	for (const FPrimaryAssetId& ItemId : ItemIds)
+	{
+		URPGItem* Item = GetPrimaryAssetObject<URPGItem>(ItemId);
+
+		if (Item)
+		{
+			CacheItem(ItemId, Item);
+		}
+	}
+
+	UE_LOG(LogActionRPG, Log, TEXT("Item cache warmed with %d items in %.2f ms"), ItemCache.Num(), (FPlatformTime::Seconds() - ItemCacheWarmStartTime) * 1000.0);
+}
+
+void URPGAssetManager::PreloadItems()
+{
+	ItemTypePreloads.Reset();
+
+	// Reserved so entries don't move if a load completes inside LoadPrimaryAssetsWithType
+	ItemTypePreloads.Reserve(PreloadItemTypes.Num());
+
+	for (const FName& TypeName : PreloadItemTypes)
+	{
+		const FPrimaryAssetType ItemType(TypeName);
+
+		FItemTypePreload& Preload = ItemTypePreloads.AddDefaulted_GetRef();
+		Preload.ItemType = ItemType;
+		Preload.StartTime = FPlatformTime::Seconds();
+		Preload.LoadSeconds = 0.0f;
+		Preload.bComplete = false;
+		Preload.Handle = LoadPrimaryAssetsWithType(ItemType, PreloadBundles, FStreamableDelegate::CreateUObject(this, &URPGAssetManager::HandleItemTypePreloaded, ItemType));
+
+		if (Preload.Handle.IsValid())
+		{
+			Preload.Handle->BindUpdateDelegate(FStreamableUpdateDelegate::CreateUObject(this, &URPGAssetManager::HandleItemPreloadUpdate));
+		}
+	}
+
+	for (const FItemTypePreload& Preload : ItemTypePreloads)
+	{
+		if (!Preload.Handle.IsValid() && !Preload.bComplete)
+		{
+			// Nothing needed loading, the delegate is not called in that case
+			HandleItemTypePreloaded(Preload.ItemType);
+		}
+	}
+
+	UpdateLoadingScreenProgress();
+}
+
+bool URPGAssetManager::IsPreloadingItems() const
+{
+	return ItemTypePreloads.ContainsByPredicate([](const FItemTypePreload& Preload) { return !Preload.bComplete; });
+}
+
+float URPGAssetManager::GetItemPreloadProgress() const
+{
+	if (ItemTypePreloads.Num() == 0)
+	{
+		return 1.0f;
+	}
+
+	float Progress = 0.0f;
+	for (const FItemTypePreload& Preload : ItemTypePreloads)
+	{
+		Progress += (Preload.bComplete || !Preload.Handle.IsValid()) ? 1.0f : Preload.Handle->GetProgress();
+	}
+	return Progress / ItemTypePreloads.Num();
+}
+
+void URPGAssetManager::GetItemPreloadTimes(TMap<FPrimaryAssetType, float>& OutLoadTimes) const
+{
+	for (const FItemTypePreload& Preload : ItemTypePreloads)
+	{
+		if (Preload.bComplete)
+		{
+			OutLoadTimes.Add(Preload.ItemType, Preload.LoadSeconds);
+		}
+	}
+}
+
+void URPGAssetManager::HandleItemTypePreloaded(FPrimaryAssetType ItemType)
+{
+	FItemTypePreload* Preload = ItemTypePreloads.FindByPredicate([ItemType](const FItemTypePreload& Entry) { return Entry.ItemType == ItemType; });
+	if (!Preload || Preload->bComplete)
+	{
+		return;
+	}
+
+	Preload->bComplete = true;
+	Preload->LoadSeconds = (float)(FPlatformTime::Seconds() - Preload->StartTime);
+
+	TArray<FPrimaryAssetId> ItemIds;
+	GetPrimaryAssetIdList(ItemType, ItemIds);
+
+	for (const FPrimaryAssetId& ItemId : ItemIds)
+	{
+		URPGItem* Item = GetPrimaryAssetObject<URPGItem>(ItemId);
+
+		if (Item)
+		{
+			CacheItem(ItemId, Item);
+		}
+	}
+
+	UE_LOG(LogActionRPG, Log, TEXT("Preloaded %d %s items in %.2f ms"), ItemIds.Num(), *ItemType.ToString(), Preload->LoadSeconds * 1000.0f);
+
+	UpdateLoadingScreenProgress();
+}
+
+void URPGAssetManager::HandleItemPreloadUpdate(TSharedRef<FStreamableHandle> Handle)
+{
+	UpdateLoadingScreenProgress();
+}
+
+void URPGAssetManager::UpdateLoadingScreenProgress() const
+{
+	// Not loaded on servers and in some editor configurations
+	IActionRPGLoadingScreenModule* LoadingScreenModule = FModuleManager::GetModulePtr<IActionRPGLoadingScreenModule>("ActionRPGLoadingScreen");
+
+	if (LoadingScreenModule)
+	{
+		// Hide the bar once the preload is done, otherwise every later loading screen would show it full
+		LoadingScreenModule->SetLoadingProgress(IsPreloadingItems() ? GetItemPreloadProgress() : -1.0f);
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+static void DumpItemCacheStats()
+{
+	URPGAssetManager& AssetManager = URPGAssetManager::Get();
+	const int32 Lookups = AssetManager.GetItemCacheHits() + AssetManager.GetItemCacheMisses();
+
+	UE_LOG(LogActionRPG, Display, TEXT("Item cache: %d items, %d hits, %d misses (%.1f%% hit rate), %.2f ms loading on misses"),
+		AssetManager.GetNumCachedItems(), AssetManager.GetItemCacheHits(), AssetManager.GetItemCacheMisses(),
+		Lookups > 0 ? 100.0 * AssetManager.GetItemCacheHits() / Lookups : 0.0, AssetManager.GetItemLoadSeconds() * 1000.0);
+
+	UE_LOG(LogActionRPG, Display, TEXT("Item icons: %.1f of %d KB resident, %d hits, %d misses, %d evictions"),
+		AssetManager.GetItemIconResidentBytes() / 1024.0, AssetManager.ItemIconBudgetKB, AssetManager.GetItemIconHits(), AssetManager.GetItemIconMisses(), AssetManager.GetItemIconEvictions());
+}
+
+static FAutoConsoleCommand DumpItemCacheStatsCommand(
+	TEXT("RPG.ItemCache.Stats"),
+	TEXT("Logs the counters of the item cache and the item icon cache"),
+	FConsoleCommandDelegate::CreateStatic(&DumpItemCacheStats));
+
+static void BenchmarkItemRegistry(const TArray<FString>& Args, UWorld* World)
+{
+	APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+	ARPGCharacterBase* Character = PlayerController ? Cast<ARPGCharacterBase>(PlayerController->GetPawn()) : nullptr;
+
+	if (!Character)
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("Item registry benchmark: needs a game world with a player controlled RPG character"));
+		return;
+	}
+
+	URPGAssetManager& AssetManager = URPGAssetManager::Get();
+	const FRPGItemRegistry& ItemRegistry = AssetManager.GetItemRegistry();
+	const int32 NumCalls = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100000;
+
+	// Only loaded items are used, a slot table gets one slot per item so every item is slotted
+	TArray<URPGItem*> Items;
+	TMap<FPrimaryAssetType, int32> SlotsPerType;
+	for (int32 Index = 0; Index < ItemRegistry.Num(); Index++)
+	{
+		URPGItem* Item = ItemRegistry.HasStats(Index) ? AssetManager.ForceLoadItem(ItemRegistry.GetAssetId(Index), false) : nullptr;
+
+		if (Item)
+		{
+			Items.Add(Item);
+			SlotsPerType.FindOrAdd(ItemRegistry.GetAssetId(Index).PrimaryAssetType)++;
+		}
+	}
+
+	if (Items.Num() == 0)
+	{
+		UE_LOG(LogActionRPG, Display, TEXT("Item registry benchmark: no loaded items"));
+		return;
+	}
+
+	FRandomStream Random(1234);
+	TArray<URPGItem*> Order;
+	Order.SetNumUninitialized(NumCalls);
+	for (URPGItem*& Entry : Order)
+	{
+		Entry = Items[Random.RandHelper(Items.Num())];
+	}
+
+	// A scratch controller keeps the player's inventory untouched. It is never finished spawning so BeginPlay does not load the save game into it,
+	// and its transaction is never committed so nothing is saved or broadcast
+	ARPGPlayerControllerBase* ScratchController = World->SpawnActorDeferred<ARPGPlayerControllerBase>(ARPGPlayerControllerBase::StaticClass(), FTransform::Identity);
+
+	if (!ScratchController)
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("Item registry benchmark: could not spawn a scratch controller"));
+		return;
+	}
+
+	ScratchController->BeginInventoryTransaction();
+
+	// First adds store the registry index, the timed calls are the common case of adding to an item already owned
+	for (URPGItem* Item : Items)
+	{
+		ScratchController->AddInventoryItem(Item, 1, 1, false);
+	}
+
+	double StartTime = FPlatformTime::Seconds();
+	for (URPGItem* Item : Order)
+	{
+		ScratchController->AddInventoryItem(Item, 1, 1, false);
+	}
+	const double AddSeconds = FPlatformTime::Seconds() - StartTime;
+
+	ScratchController->Destroy();
+
+	// The stat part of AddInventoryItem on its own, limits read from the registry with the index the inventory stores, and read off the item as before the registry
+	TArray<int32> OrderIndices;
+	OrderIndices.Reserve(Order.Num());
+	for (URPGItem* Item : Order)
+	{
+		OrderIndices.Add(Item->GetRegistryIndex());
+	}
+
+	FRPGItemData RegistryData;
+	StartTime = FPlatformTime::Seconds();
+	for (int32 ItemIndex : OrderIndices)
+	{
+		RegistryData.UpdateItemData(FRPGItemData(1, 1), ItemRegistry.GetMaxCount(ItemIndex), ItemRegistry.GetMaxLevel(ItemIndex));
+	}
+	const double RegistryUpdateSeconds = FPlatformTime::Seconds() - StartTime;
+
+	FRPGItemData ObjectData;
+	StartTime = FPlatformTime::Seconds();
+	for (URPGItem* Item : Order)
+	{
+		ObjectData.UpdateItemData(FRPGItemData(1, 1), Item->MaxCount, Item->MaxLevel);
+	}
+	const double ObjectUpdateSeconds = FPlatformTime::Seconds() - StartTime;
+
+	FRPGItemSlotTable SlotTable;
+	SlotTable.Initialize(SlotsPerType);
+	for (URPGItem* Item : Items)
+	{
+		SlotTable.SetItem(SlotTable.FindFreeSlot(Item->GetPrimaryAssetId().PrimaryAssetType), Item);
+	}
+
+	// Same loop as FillSlottedAbilitySpecs, with the index stored in the slot table, with the index read from each item, and reading the stats off the item as before the registry
+	const int32 NumPasses = FMath::Max(1, NumCalls / Items.Num());
+	FGameplayAbilitySpec ItemSpec;
+	int32 StoredSpecs = 0;
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Pass = 0; Pass < NumPasses; Pass++)
+	{
+		SlotTable.ForEachSlotWithRegistryIndex([Character, &ItemSpec, &StoredSpecs](const FRPGItemSlot& ItemSlot, URPGItem* SlottedItem, int32 ItemIndex)
+		{
+			StoredSpecs += (SlottedItem && Character->MakeItemAbilitySpec(SlottedItem, ItemIndex, ItemSpec)) ? 1 : 0;
+		});
+	}
+	const double StoredSeconds = FPlatformTime::Seconds() - StartTime;
+
+	int32 ObjectSpecs = 0;
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Pass = 0; Pass < NumPasses; Pass++)
+	{
+		SlotTable.ForEachSlot([Character, &ItemSpec, &ObjectSpecs](const FRPGItemSlot& ItemSlot, URPGItem* SlottedItem)
+		{
+			ObjectSpecs += (SlottedItem && Character->MakeItemAbilitySpec(SlottedItem, SlottedItem->GetRegistryIndex(), ItemSpec)) ? 1 : 0;
+		});
+	}
+	const double ObjectSeconds = FPlatformTime::Seconds() - StartTime;
+
+	const FName WeaponTypeName(TEXT("Weapon"));
+	int32 UObjectSpecs = 0;
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Pass = 0; Pass < NumPasses; Pass++)
+	{
+		SlotTable.ForEachSlot([Character, &WeaponTypeName, &ItemSpec, &UObjectSpecs](const FRPGItemSlot& ItemSlot, URPGItem* SlottedItem)
+		{
+			// Use the character level as default
+			int32 AbilityLevel = Character->GetCharacterLevel();
+
+			if (SlottedItem && SlottedItem->ItemType.GetName() == WeaponTypeName)
+			{
+				AbilityLevel = SlottedItem->AbilityLevel;
+			}
+
+			if (SlottedItem && SlottedItem->GrantedAbility)
+			{
+				ItemSpec = FGameplayAbilitySpec(SlottedItem->GrantedAbility, AbilityLevel, INDEX_NONE, SlottedItem);
+				UObjectSpecs++;
+			}
+		});
+	}
+	const double UObjectSeconds = FPlatformTime::Seconds() - StartTime;
+
+	const int32 NumSpecCalls = NumPasses * Items.Num();
+	UE_LOG(LogActionRPG, Display, TEXT("Item registry benchmark: %d items, AddInventoryItem %.2f ns/call over %d calls"),
+		Items.Num(), AddSeconds * 1.0e9 / NumCalls, NumCalls);
+	UE_LOG(LogActionRPG, Display, TEXT("Item registry benchmark: UpdateItemData over %d calls, registry %.2f ns/call, item object %.2f ns/call%s"),
+		NumCalls, RegistryUpdateSeconds * 1.0e9 / NumCalls, ObjectUpdateSeconds * 1.0e9 / NumCalls,
+		RegistryData == ObjectData ? TEXT("") : TEXT(" (results differ, registry stats are stale!)"));
+	UE_LOG(LogActionRPG, Display, TEXT("Item registry benchmark: ability specs over %d slots, stored index %.2f ns/slot, index from item %.2f ns/slot, item object %.2f ns/slot%s"),
+		NumSpecCalls, StoredSeconds * 1.0e9 / NumSpecCalls, ObjectSeconds * 1.0e9 / NumSpecCalls, UObjectSeconds * 1.0e9 / NumSpecCalls,
+		StoredSpecs == ObjectSpecs && StoredSpecs == UObjectSpecs ? TEXT("") : TEXT(" (results differ, registry is stale!)"));
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkItemRegistryCommand(
+	TEXT("RPG.ItemRegistry.Benchmark"),
+	TEXT("Times AddInventoryItem on a scratch controller, and the item limit and slotted ability spec lookups through the registry against reading them off the items, for every loaded item. Optional argument is the number of calls (100000)"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkItemRegistry));
+
+#endif
\ No newline at end of file
@@ -41,6 +41,11 @@ bool URPGBlueprintLibrary::IsValidItemSlot(const FRPGItemSlot& ItemSlot)
 	return ItemSlot.IsValid();
 }
 
+void URPGBlueprintLibrary::RequestItemIcon(URPGItem* Item, FOnItemIconLoaded OnLoaded)
+{
+	URPGAssetManager::Get().RequestItemIcon(Item, OnLoaded);
+}
+
 bool URPGBlueprintLibrary::DoesEffectContainerSpecHaveEffects(const FRPGGameplayEffectContainerSpec& ContainerSpec)
 {
 	return ContainerSpec.HasValidEffects();
@@ -67,11 +72,8 @@ TArray<FActiveGameplayEffectHandle> URPGBlueprintLibrary::ApplyExternalEffectCon
 	{
 		if (SpecHandle.IsValid())
 		{
-			// If effect is valid, iterate list of targets and apply to all
-			for (TSharedPtr<FGameplayAbilityTargetData> Data : ContainerSpec.TargetData.Data)
-			{
-				AllEffects.Append(Data->ApplyGameplayEffectSpec(*SpecHandle.Data.Get()));
-			}
+			// If effect is valid, apply it to all targets
+			AllEffects.Append(ContainerSpec.ApplyEffectSpecToTargets(*SpecHandle.Data.Get()));
 		}
 	}
 	return AllEffects;
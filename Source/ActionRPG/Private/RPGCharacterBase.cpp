@@ -4,6 +4,9 @@
 #include "Items/RPGItem.h"
 #include "AbilitySystemGlobals.h"
 #include "Abilities/RPGGameplayAbility.h"
+#include "Abilities/RPGAbilityGrantSubsystem.h"
+#include "Abilities/RPGCharacterSpatialHash.h"
+#include "Engine/GameInstance.h"
 
 ARPGCharacterBase::ARPGCharacterBase()
 {
@@ -16,6 +19,8 @@ ARPGCharacterBase::ARPGCharacterBase()
 
 	CharacterLevel = 1;
 	bAbilitiesInitialized = false;
+	bUpdateAbilitiesInPlaceOnLevelChange = true;
+	bHandleDamageImmediately = false;
 }
 
 UAbilitySystemComponent* ARPGCharacterBase::GetAbilitySystemComponent() const
@@ -29,6 +34,25 @@ void ARPGCharacterBase::AddStartupGameplayAbilities()
 	
 	if (GetLocalRole() == ROLE_Authority && !bAbilitiesInitialized)
 	{
+		UGameInstance* GameInstance = GetGameInstance();
+		URPGAbilityGrantSubsystem* GrantSubsystem = GameInstance ? GameInstance->GetSubsystem<URPGAbilityGrantSubsystem>() : nullptr;
+
+		// Placed instances can override the class lists, those take the per instance path below
+		const ARPGCharacterBase* ClassDefaults = GetClass()->GetDefaultObject<ARPGCharacterBase>();
+		const bool bUsesClassGrants = GameplayAbilities == ClassDefaults->GameplayAbilities && PassiveGameplayEffects == ClassDefaults->PassiveGameplayEffects;
+
+		if (GrantSubsystem && bUsesClassGrants && URPGAbilityGrantSubsystem::AreTemplatesEnabled())
+		{
+			// Every instance of this class at this level grants the same things, so the work is shared
+			TSharedRef<const FRPGAbilityGrantTemplate> GrantTemplate = GrantSubsystem->FindOrCreateTemplate(GetClass(), GetCharacterLevel(), ClassDefaults->GameplayAbilities, ClassDefaults->PassiveGameplayEffects);
+			AbilitySystemComponent->ApplyGrantTemplate(*GrantTemplate, this, PassiveEffectHandles);
+
+			AddSlottedGameplayAbilities();
+
+			bAbilitiesInitialized = true;
+			return;
+		}
+
 		// Grant abilities, but only on the server	
 		for (TSubclassOf<URPGGameplayAbility>& StartupAbility : GameplayAbilities)
 		{
@@ -45,6 +69,12 @@ void ARPGCharacterBase::AddStartupGameplayAbilities()
 			if (NewHandle.IsValid())
 			{
 				FActiveGameplayEffectHandle ActiveGEHandle = AbilitySystemComponent->ApplyGameplayEffectSpecToTarget(*NewHandle.Data.Get(), AbilitySystemComponent);
+
+				// Kept so a level change can update the effect in place
+				if (ActiveGEHandle.IsValid())
+				{
+					PassiveEffectHandles.Add(ActiveGEHandle);
+				}
 			}
 		}
 
@@ -80,6 +110,7 @@ void ARPGCharacterBase::RemoveStartupGameplayAbilities()
 		FGameplayEffectQuery Query;
 		Query.EffectSource = this;
 		AbilitySystemComponent->RemoveActiveEffects(Query);
+		PassiveEffectHandles.Reset();
 
 		RemoveSlottedGameplayAbilities(true);
 
@@ -87,9 +118,122 @@ void ARPGCharacterBase::RemoveStartupGameplayAbilities()
 	}
 }
 
+/** Returns true if the effect could be different at NewLevel, anything not a static magnitude counts as level dependent */
+static bool DoesEffectDependOnLevel(const UGameplayEffect* Effect, float OldLevel, float NewLevel)
+{
+	if (!Effect || Effect->Executions.Num() > 0)
+	{
+		return true;
+	}
+
+	for (const FGameplayModifierInfo& Modifier : Effect->Modifiers)
+	{
+		float OldMagnitude = 0.0f;
+		float NewMagnitude = 0.0f;
+
+		if (!Modifier.ModifierMagnitude.GetStaticMagnitudeIfPossible(OldLevel, OldMagnitude) || !Modifier.ModifierMagnitude.GetStaticMagnitudeIfPossible(NewLevel, NewMagnitude) || OldMagnitude != NewMagnitude)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void ARPGCharacterBase::UpdateAbilityLevels(int32 OldLevel)
+{
+	check(AbilitySystemComponent);
+
+	if (GetLocalRole() != ROLE_Authority || !bAbilitiesInitialized)
+	{
+		return;
+	}
+
+	// Startup and default slotted abilities use the character level
+	for (FGameplayAbilitySpec& Spec : AbilitySystemComponent->GetActivatableAbilities())
+	{
+		if (Spec.SourceObject == this && Spec.Level != CharacterLevel)
+		{
+			Spec.Level = CharacterLevel;
+			AbilitySystemComponent->MarkAbilitySpecDirty(Spec);
+		}
+	}
+
+	// Item abilities use the character level unless the item sets its own
+	for (const TPair<FRPGItemSlot, FGameplayAbilitySpecHandle>& SlotPair : SlottedAbilities)
+	{
+		FGameplayAbilitySpec* Spec = AbilitySystemComponent->FindAbilitySpecFromHandle(SlotPair.Value);
+		URPGItem* SlottedItem = Spec ? Cast<URPGItem>(Spec->SourceObject.Get()) : nullptr;
+		FGameplayAbilitySpec DesiredSpec;
+
+		if (SlottedItem && MakeItemAbilitySpec(SlottedItem, GetSlottedItemRegistryIndex(SlotPair.Key, SlottedItem), DesiredSpec) && Spec->Level != DesiredSpec.Level)
+		{
+			Spec->Level = DesiredSpec.Level;
+			AbilitySystemComponent->MarkAbilitySpecDirty(*Spec);
+		}
+	}
+
+	// Passives stay applied, only the ones that scale with level are recalculated
+	for (const FActiveGameplayEffectHandle& EffectHandle : PassiveEffectHandles)
+	{
+		const FActiveGameplayEffect* ActiveEffect = AbilitySystemComponent->GetActiveGameplayEffect(EffectHandle);
+
+		if (ActiveEffect && DoesEffectDependOnLevel(ActiveEffect->Spec.Def, OldLevel, CharacterLevel))
+		{
+			AbilitySystemComponent->SetActiveGameplayEffectLevel(EffectHandle, CharacterLevel);
+		}
+	}
+}
+
 void ARPGCharacterBase::OnItemSlotChanged(FRPGItemSlot ItemSlot, URPGItem* Item)
 {
-	RefreshSlottedGameplayAbilities();
+	// Only this slot can have changed, a full reconcile happens when the inventory is loaded
+	RefreshSlottedGameplayAbility(ItemSlot, Item);
+}
+
+void ARPGCharacterBase::RefreshSlottedGameplayAbility(const FRPGItemSlot& ItemSlot, URPGItem* Item)
+{
+	if (!bAbilitiesInitialized || !AbilitySystemComponent)
+	{
+		return;
+	}
+
+	// Item ability wins, otherwise fall back to the default for the slot
+	FGameplayAbilitySpec DesiredSpec;
+	bool bHasDesiredSpec = Item && MakeItemAbilitySpec(Item, GetSlottedItemRegistryIndex(ItemSlot, Item), DesiredSpec);
+
+	if (!bHasDesiredSpec)
+	{
+		const TSubclassOf<URPGGameplayAbility>* DefaultAbility = DefaultSlottedAbilities.Find(ItemSlot);
+
+		if (DefaultAbility && DefaultAbility->Get())
+		{
+			DesiredSpec = FGameplayAbilitySpec(*DefaultAbility, GetCharacterLevel(), INDEX_NONE, this);
+			bHasDesiredSpec = true;
+		}
+	}
+
+	FGameplayAbilitySpecHandle* ExistingHandle = SlottedAbilities.Find(ItemSlot);
+	FGameplayAbilitySpec* ExistingSpec = ExistingHandle ? AbilitySystemComponent->FindAbilitySpecFromHandle(*ExistingHandle) : nullptr;
+
+	if (ExistingSpec && bHasDesiredSpec && ExistingSpec->Ability == DesiredSpec.Ability && ExistingSpec->SourceObject == DesiredSpec.SourceObject)
+	{
+		// Already granted
+		return;
+	}
+
+	if (ExistingSpec)
+	{
+		AbilitySystemComponent->ClearAbility(*ExistingHandle);
+	}
+
+	if (bHasDesiredSpec)
+	{
+		SlottedAbilities.FindOrAdd(ItemSlot) = AbilitySystemComponent->GiveAbility(DesiredSpec);
+	}
+	else if (ExistingHandle)
+	{
+		*ExistingHandle = FGameplayAbilitySpecHandle();
+	}
 }
 
 void ARPGCharacterBase::RefreshSlottedGameplayAbilities()
@@ -116,28 +260,60 @@ void ARPGCharacterBase::FillSlottedAbilitySpecs(TMap<FRPGItemSlot, FGameplayAbil
 	// Now potentially override with inventory
 	if (InventorySource)
 	{
-		const TMap<FRPGItemSlot, URPGItem*>& SlottedItemMap = InventorySource->GetSlottedItemMap();
-
-		for (const TPair<FRPGItemSlot, URPGItem*>& ItemPair : SlottedItemMap)
+		InventorySource->GetSlottedItemTable().ForEachSlotWithRegistryIndex([this, &SlottedAbilitySpecs](const FRPGItemSlot& ItemSlot, URPGItem* SlottedItem, int32 ItemIndex)
 		{
-			URPGItem* SlottedItem = ItemPair.Value;
+			FGameplayAbilitySpec ItemSpec;
 
-			// Use the character level as default
-			int32 AbilityLevel = GetCharacterLevel();
-
-			if (SlottedItem && SlottedItem->ItemType.GetName() == FName(TEXT("Weapon")))
-			{
-				// Override the ability level to use the data from the slotted item
-				AbilityLevel = SlottedItem->AbilityLevel;
-			}
-
-			if (SlottedItem && SlottedItem->GrantedAbility)
+			if (SlottedItem && MakeItemAbilitySpec(SlottedItem, ItemIndex, ItemSpec))
 			{
 				// This will override anything from default
-				SlottedAbilitySpecs.Add(ItemPair.Key, FGameplayAbilitySpec(SlottedItem->GrantedAbility, AbilityLevel, INDEX_NONE, SlottedItem));
+				SlottedAbilitySpecs.Add(ItemSlot, ItemSpec);
 			}
+		});
+	}
+}
+
+int32 ARPGCharacterBase::GetSlottedItemRegistryIndex(const FRPGItemSlot& ItemSlot, const URPGItem* SlottedItem) const
+{
+	if (InventorySource)
+	{
+		const FRPGItemSlotTable& SlotTable = InventorySource->GetSlottedItemTable();
+
+		if (SlotTable.GetItem(ItemSlot) == SlottedItem)
+		{
+			return SlotTable.GetRegistryIndex(ItemSlot);
 		}
 	}
+	return INDEX_NONE;
+}
+
+bool ARPGCharacterBase::MakeItemAbilitySpec(URPGItem* SlottedItem, int32 ItemIndex, FGameplayAbilitySpec& OutSpec)
+{
+	// Stats are read from the registry rather than the item, the index normally comes from the inventory
+	const FRPGItemRegistry& ItemRegistry = URPGAssetManager::Get().GetItemRegistry();
+
+	if (ItemIndex == INDEX_NONE)
+	{
+		ItemIndex = SlottedItem->GetRegistryIndex();
+	}
+
+	TSubclassOf<URPGGameplayAbility> GrantedAbility = ItemRegistry.GetGrantedAbility(ItemIndex);
+	if (!GrantedAbility)
+	{
+		return false;
+	}
+
+	// Use the character level as default
+	int32 AbilityLevel = GetCharacterLevel();
+
+	if (ItemRegistry.GetNativeItemType(ItemIndex) == ERPGItemType::Weapon)
+	{
+		// Override the ability level to use the data from the slotted item
+		AbilityLevel = ItemRegistry.GetAbilityLevel(ItemIndex);
+	}
+
+	OutSpec = FGameplayAbilitySpec(GrantedAbility, AbilityLevel, INDEX_NONE, SlottedItem);
+	return true;
 }
 
 void ARPGCharacterBase::AddSlottedGameplayAbilities()
@@ -197,6 +373,27 @@ void ARPGCharacterBase::RemoveSlottedGameplayAbilities(bool bRemoveAll)
 	}
 }
 
+void ARPGCharacterBase::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Area target types find characters through the spatial hash
+	if (URPGCharacterSpatialHash* SpatialHash = GetWorld()->GetSubsystem<URPGCharacterSpatialHash>())
+	{
+		SpatialHash->RegisterCharacter(this);
+	}
+}
+
+void ARPGCharacterBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (URPGCharacterSpatialHash* SpatialHash = GetWorld()->GetSubsystem<URPGCharacterSpatialHash>())
+	{
+		SpatialHash->UnregisterCharacter(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void ARPGCharacterBase::PossessedBy(AController* NewController)
 {
 	Super::PossessedBy(NewController);
@@ -288,10 +485,20 @@ bool ARPGCharacterBase::SetCharacterLevel(int32 NewLevel)
 {
 	if (CharacterLevel != NewLevel && NewLevel > 0)
 	{
-		// Our level changed so we need to refresh abilities
-		RemoveStartupGameplayAbilities();
-		CharacterLevel = NewLevel;
-		AddStartupGameplayAbilities();
+		if (bUpdateAbilitiesInPlaceOnLevelChange && bAbilitiesInitialized)
+		{
+			// Keep everything granted and running, only the levels change
+			const int32 OldLevel = CharacterLevel;
+			CharacterLevel = NewLevel;
+			UpdateAbilityLevels(OldLevel);
+		}
+		else
+		{
+			// Our level changed so we need to refresh abilities
+			RemoveStartupGameplayAbilities();
+			CharacterLevel = NewLevel;
+			AddStartupGameplayAbilities();
+		}
 
 		return true;
 	}
@@ -300,6 +507,9 @@ bool ARPGCharacterBase::SetCharacterLevel(int32 NewLevel)
 
 bool ARPGCharacterBase::ActivateAbilitiesWithItemSlot(FRPGItemSlot ItemSlot, bool bAllowRemoteActivation)
 {
+	// Blueprints only set the type name
+	ItemSlot.RefreshNativeType();
+
 	FGameplayAbilitySpecHandle* FoundHandle = SlottedAbilities.Find(ItemSlot);
 
 	if (FoundHandle && AbilitySystemComponent)
@@ -312,6 +522,16 @@ bool ARPGCharacterBase::ActivateAbilitiesWithItemSlot(FRPGItemSlot ItemSlot, boo
 
 void ARPGCharacterBase::GetActiveAbilitiesWithItemSlot(FRPGItemSlot ItemSlot, TArray<URPGGameplayAbility*>& ActiveAbilities)
 {
+	ForEachActiveAbilityWithItemSlot(ItemSlot, [&ActiveAbilities](URPGGameplayAbility* ActiveAbility)
+	{
+		ActiveAbilities.Add(ActiveAbility);
+	});
+}
+
+void ARPGCharacterBase::ForEachActiveAbilityWithItemSlot(FRPGItemSlot ItemSlot, TFunctionRef<void(URPGGameplayAbility*)> Visitor)
+{
+	ItemSlot.RefreshNativeType();
+
 	FGameplayAbilitySpecHandle* FoundHandle = SlottedAbilities.Find(ItemSlot);
 
 	if (FoundHandle && AbilitySystemComponent)
@@ -320,13 +540,8 @@ void ARPGCharacterBase::GetActiveAbilitiesWithItemSlot(FRPGItemSlot ItemSlot, TA
 
 		if (FoundSpec)
 		{
-			TArray<UGameplayAbility*> AbilityInstances = FoundSpec->GetAbilityInstances();
-
 			// Find all ability instances executed from this slot
-			for (UGameplayAbility* ActiveAbility : AbilityInstances)
-			{
-				ActiveAbilities.Add(Cast<URPGGameplayAbility>(ActiveAbility));
-			}
+			URPGAbilitySystemComponent::ForEachAbilityInstance(*FoundSpec, Visitor);
 		}
 	}
 }
@@ -349,13 +564,25 @@ void ARPGCharacterBase::GetActiveAbilitiesWithTags(FGameplayTagContainer Ability
 	}
 }
 
-bool ARPGCharacterBase::GetCooldownRemainingForTag(FGameplayTagContainer CooldownTags, float& TimeRemaining, float& CooldownDuration)
+bool ARPGCharacterBase::GetCooldownRemainingForTag(const FGameplayTagContainer& CooldownTags, float& TimeRemaining, float& CooldownDuration)
 {
 	if (AbilitySystemComponent && CooldownTags.Num() > 0)
 	{
 		TimeRemaining = 0.f;
 		CooldownDuration = 0.f;
 
+		bool bAllCooldownTags = true;
+		for (const FGameplayTag& CooldownTag : CooldownTags)
+		{
+			bAllCooldownTags &= AbilitySystemComponent->IsCooldownTag(CooldownTag);
+		}
+
+		if (bAllCooldownTags)
+		{
+			// Kept up to date by effect events, so no effects are scanned here
+			return AbilitySystemComponent->GetCooldownRemaining(CooldownTags, TimeRemaining, CooldownDuration);
+		}
+
 		FGameplayEffectQuery const Query = FGameplayEffectQuery::MakeQuery_MatchAnyOwningTags(CooldownTags);
 		TArray< TPair<float, float> > DurationAndTimeRemaining = AbilitySystemComponent->GetActiveEffectsTimeRemainingAndDuration(Query);
 		if (DurationAndTimeRemaining.Num() > 0)
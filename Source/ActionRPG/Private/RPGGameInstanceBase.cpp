@@ -5,12 +5,63 @@
 #include "RPGSaveGame.h"
 #include "Items/RPGItem.h"
 #include "Kismet/GameplayStatics.h"
+#include "Async/TaskGraphInterfaces.h"
 
 URPGGameInstanceBase::URPGGameInstanceBase()
 	: SaveSlot(TEXT("SaveGame"))
 	, SaveUserIndex(0)
+	, bPreloadSaveGame(false)
+	, SaveInventoryFormat(ERPGSaveInventoryFormat::Tagged)
+	, PersistenceMode(ERPGSavePersistenceMode::Snapshot)
+	, JournalCompactionThreshold(64)
+	, MinSaveInterval(1.0f)
+	, MaxSaveLatency(3.0f)
+	, SaveRequestCount(0)
+	, SaveCoalescedCount(0)
+	, SaveWriteCount(0)
+	, SaveGameLoadSerial(0)
+	, PreloadSaveGameSerial(0)
+	, PreloadSaveUserIndex(0)
+	, PreloadSaveRequestCount(0)
+	, JournalRecordsSinceWrite(0)
+	, SavingJournalSequence(0)
+	, FirstDirtyTime(0.0)
+	, LastWriteTime(-MAX_dbl)
 {}
 
+void URPGGameInstanceBase::Init()
+{
+	Super::Init();
+
+	PreLoadMapHandle = FCoreUObjectDelegates::PreLoadMap.AddUObject(this, &URPGGameInstanceBase::HandlePreLoadMap);
+
+	// Super::Init ran the blueprint Init graph, if that loaded synchronously there is nothing left to preload
+	if (bPreloadSaveGame && !CurrentSaveGame)
+	{
+		// Read the save while the startup movie and first map load are running, instead of after
+		LoadOrCreateSaveGameAsync();
+
+		// A blueprint load of the same slot is dropped while this is in flight, see ShouldSkipBlueprintSaveGameLoad
+		PreloadSaveGameSerial = SaveGameLoadSerial;
+		PreloadSaveSlot = SaveSlot;
+		PreloadSaveUserIndex = SaveUserIndex;
+		PreloadSaveRequestCount = SaveRequestCount;
+	}
+}
+
+void URPGGameInstanceBase::Shutdown()
+{
+	FCoreUObjectDelegates::PreLoadMap.Remove(PreLoadMapHandle);
+	PreLoadMapHandle.Reset();
+
+	// There won't be another frame to finish a background write in
+	FlushSaveGameSynchronous();
+	SaveJournal.Close();
+	bHasShutDown = true;
+
+	Super::Shutdown();
+}
+
 void URPGGameInstanceBase::AddDefaultInventory(URPGSaveGame* SaveGame, bool bRemoveExtra)
 {
 	// If we want to remove extra, clear out the existing inventory
@@ -55,6 +106,10 @@ void URPGGameInstanceBase::SetSavingEnabled(bool bEnabled)
 
 bool URPGGameInstanceBase::LoadOrCreateSaveGame()
 {
+	// This replaces the result of any async load that is still running
+	SaveGameLoadSerial++;
+	bSaveGameLoadPending = false;
+
 	URPGSaveGame* LoadedSave = nullptr;
 
 	if (UGameplayStatics::DoesSaveGameExist(SaveSlot, SaveUserIndex) && bSavingEnabled)
@@ -62,10 +117,79 @@ bool URPGGameInstanceBase::LoadOrCreateSaveGame()
 		LoadedSave = Cast<URPGSaveGame>(UGameplayStatics::LoadGameFromSlot(SaveSlot, SaveUserIndex));
 	}
 
-	return HandleSaveGameLoaded(LoadedSave);
+	return ApplySaveGame(LoadedSave);
+}
+
+void URPGGameInstanceBase::LoadOrCreateSaveGameAsync()
+{
+	SaveGameLoadSerial++;
+
+	if (!bSavingEnabled)
+	{
+		// Nothing to read, create the new save right away
+		bSaveGameLoadPending = false;
+		ApplySaveGame(nullptr);
+		return;
+	}
+
+	// A missing slot comes back as null, which creates a new save the same as the synchronous path
+	bSaveGameLoadPending = true;
+	UGameplayStatics::AsyncLoadGameFromSlot(SaveSlot, SaveUserIndex, FAsyncLoadGameFromSlotDelegate::CreateUObject(this, &URPGGameInstanceBase::HandleAsyncLoad, SaveGameLoadSerial));
+}
+
+bool URPGGameInstanceBase::IsSaveGameLoading() const
+{
+	return bSaveGameLoadPending;
+}
+
+void URPGGameInstanceBase::HandleAsyncLoad(const FString& SlotName, const int32 UserIndex, USaveGame* LoadedSave, int32 LoadSerial)
+{
+	if (LoadSerial != SaveGameLoadSerial || !bSaveGameLoadPending)
+	{
+		// Another load or reset happened while this one was in flight
+		return;
+	}
+
+	bSaveGameLoadPending = false;
+	ApplySaveGame(LoadedSave);
+
+	if (LoadSerial == PreloadSaveGameSerial)
+	{
+		// Anything the load itself saved is already on disk, so a blueprint load of the slot after this still returns the same data
+		PreloadSaveRequestCount = SaveRequestCount;
+	}
+}
+
+bool URPGGameInstanceBase::ShouldSkipBlueprintSaveGameLoad() const
+{
+	// Any other load or reset since the preload changes the serial, and a different slot or user is a new load
+	if (PreloadSaveGameSerial == 0 || SaveGameLoadSerial != PreloadSaveGameSerial || SaveSlot != PreloadSaveSlot || SaveUserIndex != PreloadSaveUserIndex)
+	{
+		return false;
+	}
+
+	// While the preload is in flight it will apply this slot itself. Once applied, a load of the same slot only repeats it unless a save was requested since
+	return bSaveGameLoadPending || SaveRequestCount == PreloadSaveRequestCount;
 }
 
 bool URPGGameInstanceBase::HandleSaveGameLoaded(USaveGame* SaveGameObject)
+{
+	if (ShouldSkipBlueprintSaveGameLoad())
+	{
+		// The preload reads the same slot, applying it again would fire OnSaveGameLoaded and reload the inventory twice. Only one result is dropped
+		PreloadSaveGameSerial = 0;
+		UE_LOG(LogActionRPG, Log, TEXT("HandleSaveGameLoaded: Ignoring the blueprint load of %s, it was preloaded by Init"), *SaveSlot);
+		return SaveGameObject != nullptr;
+	}
+
+	// Loads from blueprint go through the same serial as native ones, so a native load still in flight can't overwrite this one
+	SaveGameLoadSerial++;
+	bSaveGameLoadPending = false;
+
+	return ApplySaveGame(SaveGameObject);
+}
+
+bool URPGGameInstanceBase::ApplySaveGame(USaveGame* SaveGameObject)
 {
 	bool bLoaded = false;
 
@@ -92,6 +216,16 @@ bool URPGGameInstanceBase::HandleSaveGameLoaded(USaveGame* SaveGameObject)
 		AddDefaultInventory(CurrentSaveGame, true);
 	}
 
+	if (IsJournalingSaves())
+	{
+		// Changes made after the snapshot was written are only in the journal
+		SaveJournal.Open(SaveSlot, SaveUserIndex);
+		SaveJournal.Replay(CurrentSaveGame);
+		JournalRecordsSinceWrite = 0;
+	}
+
+	CurrentSaveGame->InventoryFormat = SaveInventoryFormat;
+
 	OnSaveGameLoaded.Broadcast(CurrentSaveGame);
 	OnSaveGameLoadedNative.Broadcast(CurrentSaveGame);
 
@@ -108,27 +242,259 @@ bool URPGGameInstanceBase::WriteSaveGame()
 {
 	if (bSavingEnabled)
 	{
-		if (bCurrentlySaving)
+		SaveRequestCount++;
+
+		if (IsJournalingSaves())
 		{
-			// Schedule another save to happen after current one finishes. We only queue one save
-			bPendingSaveRequested = true;
-			return true;
+			// Journaled changes are already on disk, a snapshot is only needed to compact the journal or for changes that were not journaled
+			const bool bChangesJournaled = JournalRecordsSinceWrite > 0;
+			JournalRecordsSinceWrite = 0;
+
+			if (bChangesJournaled && SaveJournal.Num() < JournalCompactionThreshold)
+			{
+				return true;
+			}
 		}
 
-		// Indicate that we're currently doing an async save
-		bCurrentlySaving = true;
+		if (bSaveGameDirty)
+		{
+			// A write is already waiting, it will pick up this change too
+			SaveCoalescedCount++;
+			return true;
+		}
 
-		// This goes off in the background
-		UGameplayStatics::AsyncSaveGameToSlot(GetCurrentSaveGame(), SaveSlot, SaveUserIndex, FAsyncSaveGameToSlotDelegate::CreateUObject(this, &URPGGameInstanceBase::HandleAsyncSave));
+		bSaveGameDirty = true;
+		FirstDirtyTime = FPlatformTime::Seconds();
+		ScheduleSave();
 		return true;
 	}
 	return false;
 }
 
+void URPGGameInstanceBase::FlushSaveGame()
+{
+	if (!bSaveGameDirty)
+	{
+		return;
+	}
+
+	if (bCurrentlySaving)
+	{
+		// Only one write at a time, start the next one as soon as this finishes
+		bFlushRequested = true;
+		return;
+	}
+
+	StartAsyncSave();
+}
+
 void URPGGameInstanceBase::ResetSaveGame()
 {
-	// Call handle function with no loaded save, this will reset the data
-	HandleSaveGameLoaded(nullptr);
+	// Anything requested before the reset should still make it to disk. It has to be written from the old save,
+	// a write that starts after the swap below would put the reset save in the slot
+	FlushSaveGameSynchronous();
+
+	if (bSaveGameDirty)
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("ResetSaveGame: Changes made before the reset were not written!"));
+	}
+
+	// Nothing that was waiting applies to the new save, it is only written by the next WriteSaveGame
+	bSaveGameDirty = false;
+	bFlushRequested = false;
+
+	if (SaveTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(SaveTickerHandle);
+		SaveTickerHandle.Reset();
+	}
+
+	// A reset wins over any load still in flight
+	SaveGameLoadSerial++;
+	bSaveGameLoadPending = false;
+
+	if (IsJournalingSaves())
+	{
+		// The journal holds changes to the old save, they must not be replayed onto the new one
+		SaveJournal.Open(SaveSlot, SaveUserIndex);
+		SaveJournal.Reset();
+	}
+
+	// Apply no loaded save, this will reset the data
+	ApplySaveGame(nullptr);
+}
+
+void URPGGameInstanceBase::ScheduleSave()
+{
+	if (!bSaveGameDirty || bCurrentlySaving)
+	{
+		// HandleAsyncSave schedules again when the current write finishes
+		return;
+	}
+
+	// Wait for the minimum interval, but never past the maximum latency
+	const double Now = FPlatformTime::Seconds();
+	const double WriteTime = FMath::Min(FMath::Max(LastWriteTime + MinSaveInterval, Now), FirstDirtyTime + MaxSaveLatency);
+
+	if (WriteTime <= Now)
+	{
+		StartAsyncSave();
+	}
+	else if (!SaveTickerHandle.IsValid())
+	{
+		SaveTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &URPGGameInstanceBase::HandleSaveTicker), (float)(WriteTime - Now));
+	}
+}
+
+void URPGGameInstanceBase::StartAsyncSave()
+{
+	if (SaveTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(SaveTickerHandle);
+		SaveTickerHandle.Reset();
+	}
+
+	// Indicate that we're currently doing an async save
+	bSaveGameDirty = false;
+	bFlushRequested = false;
+	bCurrentlySaving = true;
+	LastWriteTime = FPlatformTime::Seconds();
+	SaveWriteCount++;
+
+	UE_LOG(LogActionRPG, Verbose, TEXT("Writing save game: %d requests, %d coalesced, %d writes"), SaveRequestCount, SaveCoalescedCount, SaveWriteCount);
+
+	PrepareSnapshot();
+
+	// This goes off in the background
+	UGameplayStatics::AsyncSaveGameToSlot(GetCurrentSaveGame(), SaveSlot, SaveUserIndex, FAsyncSaveGameToSlotDelegate::CreateUObject(this, &URPGGameInstanceBase::HandleAsyncSave));
+}
+
+void URPGGameInstanceBase::FlushSaveGameSynchronous()
+{
+	if (bCurrentlySaving)
+	{
+		// The background write goes to the same slot, so writing now would race it. Its callback is dispatched on this thread
+		const double GiveUpTime = FPlatformTime::Seconds() + 10.0;
+		while (bCurrentlySaving && FPlatformTime::Seconds() < GiveUpTime)
+		{
+			FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+
+			if (bCurrentlySaving)
+			{
+				FPlatformProcess::Sleep(0.001f);
+			}
+		}
+
+		if (bCurrentlySaving)
+		{
+			// Keep the dirty flag, the changes are still in memory if anything flushes again
+			UE_LOG(LogActionRPG, Warning, TEXT("FlushSaveGameSynchronous: Background save did not finish, latest changes were not written!"));
+			return;
+		}
+	}
+
+	// Finishing the background write may have scheduled the next one
+	if (SaveTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(SaveTickerHandle);
+		SaveTickerHandle.Reset();
+	}
+
+	if (bSaveGameDirty && bSavingEnabled && GetCurrentSaveGame())
+	{
+		bSaveGameDirty = false;
+		bFlushRequested = false;
+		LastWriteTime = FPlatformTime::Seconds();
+		SaveWriteCount++;
+
+		PrepareSnapshot();
+		HandleSnapshotWritten(UGameplayStatics::SaveGameToSlot(GetCurrentSaveGame(), SaveSlot, SaveUserIndex));
+	}
+}
+
+bool URPGGameInstanceBase::HandleSaveTicker(float DeltaTime)
+{
+	SaveTickerHandle.Reset();
+	ScheduleSave();
+
+	// One shot
+	return false;
+}
+
+bool URPGGameInstanceBase::IsJournalingSaves() const
+{
+	return PersistenceMode == ERPGSavePersistenceMode::Journaled && bSavingEnabled;
+}
+
+void URPGGameInstanceBase::JournalInventoryItem(const FPrimaryAssetId& ItemId, const FRPGItemData* ItemData)
+{
+	if (!IsJournalingSaves())
+	{
+		return;
+	}
+
+	FRPGSaveJournalRecord Record;
+	Record.Type = ItemData ? FRPGSaveJournalRecord::EType::SetItem : FRPGSaveJournalRecord::EType::RemoveItem;
+	Record.ItemId = ItemId;
+	if (ItemData)
+	{
+		Record.ItemData = *ItemData;
+	}
+
+	// If the append fails, the next WriteSaveGame falls back to a snapshot
+	if (SaveJournal.Append(Record) && JournalRecordsSinceWrite >= 0)
+	{
+		JournalRecordsSinceWrite++;
+	}
+	else
+	{
+		JournalRecordsSinceWrite = INDEX_NONE;
+	}
+}
+
+void URPGGameInstanceBase::JournalSlottedItem(const FRPGItemSlot& ItemSlot, const FPrimaryAssetId& ItemId)
+{
+	if (!IsJournalingSaves())
+	{
+		return;
+	}
+
+	FRPGSaveJournalRecord Record;
+	Record.Type = FRPGSaveJournalRecord::EType::SetSlot;
+	Record.ItemId = ItemId;
+	Record.ItemSlot = ItemSlot;
+
+	if (SaveJournal.Append(Record) && JournalRecordsSinceWrite >= 0)
+	{
+		JournalRecordsSinceWrite++;
+	}
+	else
+	{
+		JournalRecordsSinceWrite = INDEX_NONE;
+	}
+}
+
+void URPGGameInstanceBase::PrepareSnapshot()
+{
+	if (IsJournalingSaves() && GetCurrentSaveGame())
+	{
+		// Everything journaled so far is already applied to the save game, so the snapshot covers it
+		SavingJournalSequence = SaveJournal.GetLastSequence();
+		GetCurrentSaveGame()->JournalSequence = SavingJournalSequence;
+	}
+}
+
+void URPGGameInstanceBase::HandleSnapshotWritten(bool bSuccess)
+{
+	if (bSuccess && IsJournalingSaves())
+	{
+		SaveJournal.Compact(SavingJournalSequence);
+	}
+}
+
+void URPGGameInstanceBase::HandlePreLoadMap(const FString& MapName)
+{
+	FlushSaveGame();
 }
 
 void URPGGameInstanceBase::HandleAsyncSave(const FString& SlotName, const int32 UserIndex, bool bSuccess)
@@ -136,10 +502,23 @@ void URPGGameInstanceBase::HandleAsyncSave(const FString& SlotName, const int32
 	ensure(bCurrentlySaving);
 	bCurrentlySaving = false;
 
-	if (bPendingSaveRequested)
+	if (bHasShutDown)
+	{
+		return;
+	}
+
+	HandleSnapshotWritten(bSuccess);
+
+	if (bSaveGameDirty)
 	{
-		// Start another save as we got a request while saving
-		bPendingSaveRequested = false;
-		WriteSaveGame();
+		// Changes came in while saving, write them now if flushed or when the scheduler allows
+		if (bFlushRequested)
+		{
+			StartAsyncSave();
+		}
+		else
+		{
+			ScheduleSave();
+		}
 	}
 }
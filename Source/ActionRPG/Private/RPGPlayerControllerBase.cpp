@@ -21,18 +21,34 @@ bool ARPGPlayerControllerBase::AddInventoryItem(URPGItem* NewItem, int32 ItemCou
 		return false;
 	}
 
+	if (IsInventoryLoading())
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("AddInventoryItem: Failed trying to add item %s while the inventory is loading!"), *NewItem->GetName());
+		return false;
+	}
+
 	// Find current item data, which may be empty
 	FRPGItemData OldData;
 	GetInventoryItemData(NewItem, OldData);
 
-	// Find modified data
+	// Find modified data, the limits come from the item registry
+	const FRPGItemRegistry& ItemRegistry = URPGAssetManager::Get().GetItemRegistry();
+	const int32 ItemIndex = GetInventoryRegistryIndex(NewItem);
+
 	FRPGItemData NewData = OldData;
-	NewData.UpdateItemData(FRPGItemData(ItemCount, ItemLevel), NewItem->MaxCount, NewItem->MaxLevel);
+	NewData.UpdateItemData(FRPGItemData(ItemCount, ItemLevel), ItemRegistry.GetMaxCount(ItemIndex), ItemRegistry.GetMaxLevel(ItemIndex));
 
 	if (OldData != NewData)
 	{
+		if (!OldData.IsValid())
+		{
+			// First copy of this item, so it needs to go in the type index
+			AddToInventoryTypeIndex(NewItem, ItemIndex);
+		}
+
 		// If data changed, need to update storage and call callback
 		InventoryData.Add(NewItem, NewData);
+		MarkInventoryItemDirty(NewItem);
 		NotifyInventoryItemChanged(true, NewItem);
 		bChanged = true;
 	}
@@ -60,6 +76,12 @@ bool ARPGPlayerControllerBase::RemoveInventoryItem(URPGItem* RemovedItem, int32
 		return false;
 	}
 
+	if (IsInventoryLoading())
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("RemoveInventoryItem: Failed trying to remove item %s while the inventory is loading!"), *RemovedItem->GetName());
+		return false;
+	}
+
 	// Find current item data, which may be empty
 	FRPGItemData NewData;
 	GetInventoryItemData(RemovedItem, NewData);
@@ -84,19 +106,21 @@ bool ARPGPlayerControllerBase::RemoveInventoryItem(URPGItem* RemovedItem, int32
 	{
 		// Update data with new count
 		InventoryData.Add(RemovedItem, NewData);
+		MarkInventoryItemDirty(RemovedItem);
 	}
 	else
 	{
 		// Remove item entirely, make sure it is unslotted
 		InventoryData.Remove(RemovedItem);
+		RemoveFromInventoryTypeIndex(RemovedItem);
+		MarkInventoryItemDirty(RemovedItem);
 
-		for (TPair<FRPGItemSlot, URPGItem*>& Pair : SlottedItems)
+		FRPGItemSlot RemovedSlot = SlottedItems.FindItemSlot(RemovedItem);
+		if (RemovedSlot.IsValid())
 		{
-			if (Pair.Value == RemovedItem)
-			{
-				Pair.Value = nullptr;
-				NotifySlottedItemChanged(Pair.Key, Pair.Value);
-			}
+			SlottedItems.SetItem(RemovedSlot, nullptr);
+			MarkSlotDirty(RemovedSlot);
+			NotifySlottedItemChanged(RemovedSlot, nullptr);
 		}
 	}
 
@@ -109,49 +133,64 @@ bool ARPGPlayerControllerBase::RemoveInventoryItem(URPGItem* RemovedItem, int32
 
 void ARPGPlayerControllerBase::GetInventoryItems(TArray<URPGItem*>& Items, FPrimaryAssetType ItemType)
 {
+	if (ItemType.IsValid())
+	{
+		// Only the items of this type need to be visited
+		const TArray<URPGItem*>* FoundItems = InventoryItemsByType.Find(ItemType);
+
+		if (FoundItems)
+		{
+			Items.Append(*FoundItems);
+		}
+		return;
+	}
+
+	// No filter, so return everything
+	Items.Reserve(Items.Num() + InventoryData.Num());
 	for (const TPair<URPGItem*, FRPGItemData>& Pair : InventoryData)
 	{
 		if (Pair.Key)
 		{
-			FPrimaryAssetId AssetId = Pair.Key->GetPrimaryAssetId();
-
-			// Filters based on item type
-			if (AssetId.PrimaryAssetType == ItemType || !ItemType.IsValid())
-			{
-				Items.Add(Pair.Key);
-			}
-		}	
+			Items.Add(Pair.Key);
+		}
 	}
 }
 
 bool ARPGPlayerControllerBase::SetSlottedItem(FRPGItemSlot ItemSlot, URPGItem* Item)
 {
-	// Iterate entire inventory because we need to remove from old slot
-	bool bFound = false;
-	for (TPair<FRPGItemSlot, URPGItem*>& Pair : SlottedItems)
+	// Blueprints only set the type name
+	ItemSlot.RefreshNativeType();
+
+	if (!SlottedItems.IsValidSlot(ItemSlot))
 	{
-		if (Pair.Key == ItemSlot)
-		{
-			// Add to new slot
-			bFound = true;
-			Pair.Value = Item;
-			NotifySlottedItemChanged(Pair.Key, Pair.Value);
-		}
-		else if (Item != nullptr && Pair.Value == Item)
-		{
-			// If this item was found in another slot, remove it
-			Pair.Value = nullptr;
-			NotifySlottedItemChanged(Pair.Key, Pair.Value);
-		}
+		return false;
 	}
 
-	if (bFound)
+	if (IsInventoryLoading())
 	{
-		SaveInventory();
-		return true;
+		UE_LOG(LogActionRPG, Warning, TEXT("SetSlottedItem: Failed trying to change a slot while the inventory is loading!"));
+		return false;
 	}
 
-	return false;
+	if (Item != nullptr)
+	{
+		// If this item was found in another slot, remove it
+		FRPGItemSlot OldSlot = SlottedItems.FindItemSlot(Item);
+		if (OldSlot.IsValid() && OldSlot != ItemSlot)
+		{
+			SlottedItems.SetItem(OldSlot, nullptr);
+			MarkSlotDirty(OldSlot);
+			NotifySlottedItemChanged(OldSlot, nullptr);
+		}
+	}
+
+	// Add to new slot
+	SlottedItems.SetItem(ItemSlot, Item, Item ? GetInventoryRegistryIndex(Item) : INDEX_NONE);
+	MarkSlotDirty(ItemSlot);
+	NotifySlottedItemChanged(ItemSlot, Item);
+
+	SaveInventory();
+	return true;
 }
 
 int32 ARPGPlayerControllerBase::GetInventoryItemCount(URPGItem* Item) const
@@ -180,24 +219,27 @@ bool ARPGPlayerControllerBase::GetInventoryItemData(URPGItem* Item, FRPGItemData
 
 URPGItem* ARPGPlayerControllerBase::GetSlottedItem(FRPGItemSlot ItemSlot) const
 {
-	URPGItem* const* FoundItem = SlottedItems.Find(ItemSlot);
-
-	if (FoundItem)
-	{
-		return *FoundItem;
-	}
-	return nullptr;
+	return SlottedItems.GetItem(ItemSlot);
 }
 
 void ARPGPlayerControllerBase::GetSlottedItems(TArray<URPGItem*>& Items, FPrimaryAssetType ItemType, bool bOutputEmptyIndexes)
 {
-	for (TPair<FRPGItemSlot, URPGItem*>& Pair : SlottedItems)
+	if (ItemType.IsValid())
 	{
-		if (Pair.Key.ItemType == ItemType || !ItemType.IsValid())
+		const FRPGItemSlotArray* SlotArray = SlottedItems.FindSlotArray(ItemType);
+
+		if (SlotArray)
 		{
-			Items.Add(Pair.Value);
+			Items.Append(SlotArray->Items);
 		}
+		return;
 	}
+
+	Items.Reserve(Items.Num() + SlottedItems.Num());
+	SlottedItems.ForEachSlot([&Items](const FRPGItemSlot& ItemSlot, URPGItem* Item)
+	{
+		Items.Add(Item);
+	});
 }
 
 void ARPGPlayerControllerBase::FillEmptySlots()
@@ -214,8 +256,71 @@ void ARPGPlayerControllerBase::FillEmptySlots()
 	}
 }
 
+void ARPGPlayerControllerBase::BeginInventoryTransaction()
+{
+	InventoryTransactionDepth++;
+}
+
+void ARPGPlayerControllerBase::CommitInventoryTransaction()
+{
+	if (InventoryTransactionDepth <= 0)
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("CommitInventoryTransaction: Called without a matching BeginInventoryTransaction!"));
+		return;
+	}
+
+	InventoryTransactionDepth--;
+	if (InventoryTransactionDepth > 0)
+	{
+		// An outer transaction is still open
+		return;
+	}
+
+	// Move the pending changes out first, as callbacks are allowed to start a new transaction
+	TMap<URPGItem*, bool> ItemChanges = MoveTemp(PendingItemChanges);
+	TSet<FRPGItemSlot> SlotChanges = MoveTemp(PendingSlotChanges);
+	const bool bShouldSave = bPendingInventorySave;
+
+	PendingItemChanges.Reset();
+	PendingSlotChanges.Reset();
+	bPendingInventorySave = false;
+
+	for (const TPair<URPGItem*, bool>& Pair : ItemChanges)
+	{
+		NotifyInventoryItemChanged(Pair.Value, Pair.Key);
+	}
+
+	for (const FRPGItemSlot& ItemSlot : SlotChanges)
+	{
+		NotifySlottedItemChanged(ItemSlot, SlottedItems.GetItem(ItemSlot));
+	}
+
+	if (bShouldSave)
+	{
+		SaveInventory();
+	}
+}
+
+bool ARPGPlayerControllerBase::IsInInventoryTransaction() const
+{
+	return InventoryTransactionDepth > 0;
+}
+
 bool ARPGPlayerControllerBase::SaveInventory()
 {
+	if (IsInInventoryTransaction())
+	{
+		// Save once when the transaction commits
+		bPendingInventorySave = true;
+		return true;
+	}
+
+	if (IsInventoryLoading())
+	{
+		// The arrays are empty until the load completes, writing them now would wipe the save game. bSaveAllInventory stays set, so the first save after the load writes everything
+		return false;
+	}
+
 	UWorld* World = GetWorld();
 	URPGGameInstanceBase* GameInstance = World ? World->GetGameInstance<URPGGameInstanceBase>() : nullptr;
 
@@ -227,32 +332,80 @@ bool ARPGPlayerControllerBase::SaveInventory()
 	URPGSaveGame* CurrentSaveGame = GameInstance->GetCurrentSaveGame();
 	if (CurrentSaveGame)
 	{
-		// Reset cached data in save game before writing to it
-		CurrentSaveGame->InventoryData.Reset();
-		CurrentSaveGame->SlottedItems.Reset();
+		int32 EntriesWritten = 0;
 
-		for (const TPair<URPGItem*, FRPGItemData>& ItemPair : InventoryData)
+		if (bSaveAllInventory || LastSavedGame.Get() != CurrentSaveGame)
 		{
-			FPrimaryAssetId AssetId;
+			// Reset cached data in save game before writing to it
+			CurrentSaveGame->InventoryData.Reset();
+			CurrentSaveGame->SlottedItems.Reset();
 
-			if (ItemPair.Key)
+			for (const TPair<URPGItem*, FRPGItemData>& ItemPair : InventoryData)
 			{
-				AssetId = ItemPair.Key->GetPrimaryAssetId();
-				CurrentSaveGame->InventoryData.Add(AssetId, ItemPair.Value);
+				FPrimaryAssetId AssetId;
+
+				if (ItemPair.Key)
+				{
+					AssetId = ItemPair.Key->GetPrimaryAssetId();
+					CurrentSaveGame->InventoryData.Add(AssetId, ItemPair.Value);
+					EntriesWritten++;
+				}
 			}
-		}
 
-		for (const TPair<FRPGItemSlot, URPGItem*>& SlotPair : SlottedItems)
+			SlottedItems.ForEachSlot([CurrentSaveGame, &EntriesWritten](const FRPGItemSlot& ItemSlot, URPGItem* Item)
+			{
+				FPrimaryAssetId AssetId;
+
+				if (Item)
+				{
+					AssetId = Item->GetPrimaryAssetId();
+				}
+				CurrentSaveGame->SlottedItems.Add(ItemSlot, AssetId);
+				EntriesWritten++;
+			});
+		}
+		else
 		{
-			FPrimaryAssetId AssetId;
+			// Only write the entries that changed, removed items are no longer in InventoryData
+			for (const TPair<URPGItem*, FPrimaryAssetId>& DirtyPair : DirtyItems)
+			{
+				const FRPGItemData* FoundData = InventoryData.Find(DirtyPair.Key);
+
+				if (FoundData)
+				{
+					CurrentSaveGame->InventoryData.Add(DirtyPair.Value, *FoundData);
+				}
+				else
+				{
+					CurrentSaveGame->InventoryData.Remove(DirtyPair.Value);
+				}
+				GameInstance->JournalInventoryItem(DirtyPair.Value, FoundData);
+				EntriesWritten++;
+			}
 
-			if (SlotPair.Value)
+			for (const FRPGItemSlot& ItemSlot : DirtySlots)
 			{
-				AssetId = SlotPair.Value->GetPrimaryAssetId();
+				FPrimaryAssetId AssetId;
+				URPGItem* Item = SlottedItems.GetItem(ItemSlot);
+
+				if (Item)
+				{
+					AssetId = Item->GetPrimaryAssetId();
+				}
+				CurrentSaveGame->SlottedItems.Add(ItemSlot, AssetId);
+				GameInstance->JournalSlottedItem(ItemSlot, AssetId);
+				EntriesWritten++;
 			}
-			CurrentSaveGame->SlottedItems.Add(SlotPair.Key, AssetId);
 		}
 
+		DirtyItems.Reset();
+		DirtySlots.Reset();
+		bSaveAllInventory = false;
+		LastSavedGame = CurrentSaveGame;
+		LastSaveEntriesWritten = EntriesWritten;
+
+		UE_LOG(LogActionRPG, Verbose, TEXT("SaveInventory: Wrote %d entries to save game"), EntriesWritten);
+
 		// Now that cache is updated, write to disk
 		GameInstance->WriteSaveGame();
 		return true;
@@ -263,8 +416,23 @@ bool ARPGPlayerControllerBase::SaveInventory()
 bool ARPGPlayerControllerBase::LoadInventory()
 {
 	InventoryData.Reset();
+	InventoryItemsByType.Reset();
+	InventoryRegistryIndices.Reset();
 	SlottedItems.Reset();
 
+	// Loaded notification below replaces anything still pending from a transaction
+	PendingItemChanges.Reset();
+	PendingSlotChanges.Reset();
+
+	// The next save writes everything, as the save game may not match what was loaded
+	DirtyItems.Reset();
+	DirtySlots.Reset();
+	bSaveAllInventory = true;
+
+	// Any async load that is still running is now out of date
+	InventoryLoadSerial++;
+	bInventoryLoadPending = false;
+
 	// Fill in slots from game instance
 	UWorld* World = GetWorld();
 	URPGGameInstanceBase* GameInstance = World ? World->GetGameInstance<URPGGameInstanceBase>() : nullptr;
@@ -280,49 +448,38 @@ bool ARPGPlayerControllerBase::LoadInventory()
 		GameInstance->OnSaveGameLoadedNative.AddUObject(this, &ARPGPlayerControllerBase::HandleSaveGameLoaded);
 	}
 
-	for (const TPair<FPrimaryAssetType, int32>& Pair : GameInstance->ItemSlotsPerType)
-	{
-		for (int32 SlotNumber = 0; SlotNumber < Pair.Value; SlotNumber++)
-		{
-			SlottedItems.Add(FRPGItemSlot(Pair.Key, SlotNumber), nullptr);
-		}
-	}
+	SlottedItems.Initialize(GameInstance->ItemSlotsPerType);
 
 	URPGSaveGame* CurrentSaveGame = GameInstance->GetCurrentSaveGame();
-	URPGAssetManager& AssetManager = URPGAssetManager::Get();
 	if (CurrentSaveGame)
 	{
-		// Copy from save game into controller data
-		bool bFoundAnySlots = false;
-		for (const TPair<FPrimaryAssetId, FRPGItemData>& ItemPair : CurrentSaveGame->InventoryData)
+		if (bAsyncLoadInventory && (CurrentSaveGame->InventoryData.Num() > 0 || CurrentSaveGame->SlottedItems.Num() > 0))
 		{
-			URPGItem* LoadedItem = AssetManager.ForceLoadItem(ItemPair.Key);
-
-			if (LoadedItem != nullptr)
-			{
-				InventoryData.Add(LoadedItem, ItemPair.Value);
-			}
-		}
+			// Request every referenced item as one batch, the inventory is filled in when it completes
+			TSet<FPrimaryAssetId> ItemIds;
+			CurrentSaveGame->InventoryData.GetKeys(ItemIds);
 
-		for (const TPair<FRPGItemSlot, FPrimaryAssetId>& SlotPair : CurrentSaveGame->SlottedItems)
-		{
-			if (SlotPair.Value.IsValid())
+			for (const TPair<FRPGItemSlot, FPrimaryAssetId>& SlotPair : CurrentSaveGame->SlottedItems)
 			{
-				URPGItem* LoadedItem = AssetManager.ForceLoadItem(SlotPair.Value);
-				if (GameInstance->IsValidItemSlot(SlotPair.Key) && LoadedItem)
+				if (SlotPair.Value.IsValid())
 				{
-					SlottedItems.Add(SlotPair.Key, LoadedItem);
-					bFoundAnySlots = true;
+					ItemIds.Add(SlotPair.Value);
 				}
 			}
-		}
 
-		if (!bFoundAnySlots)
-		{
-			// Auto slot items as no slots were saved
-			FillEmptySlots();
+			// The delegate may run before this returns if everything is already in memory
+			bInventoryLoadPending = true;
+			TSharedPtr<FStreamableHandle> LoadHandle = URPGAssetManager::Get().LoadPrimaryAssets(ItemIds.Array(), TArray<FName>(), FStreamableDelegate::CreateUObject(this, &ARPGPlayerControllerBase::HandleInventoryItemsLoaded, InventoryLoadSerial));
+
+			if (!LoadHandle.IsValid())
+			{
+				// Nothing was requested, so finish now. This does nothing if the delegate already ran
+				HandleInventoryItemsLoaded(InventoryLoadSerial);
+			}
+			return true;
 		}
 
+		CopyInventoryFromSaveGame(CurrentSaveGame);
 		NotifyInventoryLoaded();
 
 		return true;
@@ -334,31 +491,137 @@ bool ARPGPlayerControllerBase::LoadInventory()
 	return false;
 }
 
-bool ARPGPlayerControllerBase::FillEmptySlotWithItem(URPGItem* NewItem)
+bool ARPGPlayerControllerBase::IsInventoryLoading() const
+{
+	return bInventoryLoadPending;
+}
+
+void ARPGPlayerControllerBase::CopyInventoryFromSaveGame(URPGSaveGame* SaveGame)
 {
-	// Look for an empty item slot to fill with this item
-	FPrimaryAssetType NewItemType = NewItem->GetPrimaryAssetId().PrimaryAssetType;
-	FRPGItemSlot EmptySlot;
-	for (TPair<FRPGItemSlot, URPGItem*>& Pair : SlottedItems)
+	URPGAssetManager& AssetManager = URPGAssetManager::Get();
+
+	// Copy from save game into controller data
+	bool bFoundAnySlots = false;
+	for (const TPair<FPrimaryAssetId, FRPGItemData>& ItemPair : SaveGame->InventoryData)
 	{
-		if (Pair.Key.ItemType == NewItemType)
+		URPGItem* LoadedItem = AssetManager.ForceLoadItem(ItemPair.Key);
+
+		if (LoadedItem != nullptr)
 		{
-			if (Pair.Value == NewItem)
+			if (!InventoryData.Contains(LoadedItem))
 			{
-				// Item is already slotted
-				return false;
+				AddToInventoryTypeIndex(LoadedItem, LoadedItem->GetRegistryIndex());
 			}
-			else if (Pair.Value == nullptr && (!EmptySlot.IsValid() || EmptySlot.SlotNumber > Pair.Key.SlotNumber))
+			InventoryData.Add(LoadedItem, ItemPair.Value);
+		}
+	}
+
+	for (const TPair<FRPGItemSlot, FPrimaryAssetId>& SlotPair : SaveGame->SlottedItems)
+	{
+		if (SlotPair.Value.IsValid())
+		{
+			URPGItem* LoadedItem = AssetManager.ForceLoadItem(SlotPair.Value);
+			if (LoadedItem && SlottedItems.SetItem(SlotPair.Key, LoadedItem, GetInventoryRegistryIndex(LoadedItem)))
 			{
-				// We found an empty slot worth filling
-				EmptySlot = Pair.Key;
+				bFoundAnySlots = true;
 			}
 		}
 	}
 
+	if (!bFoundAnySlots)
+	{
+		// Auto slot items as no slots were saved
+		FillEmptySlots();
+	}
+}
+
+void ARPGPlayerControllerBase::HandleInventoryItemsLoaded(int32 LoadSerial)
+{
+	if (LoadSerial != InventoryLoadSerial || !bInventoryLoadPending)
+	{
+		// Inventory was reloaded while this batch was in flight
+		return;
+	}
+
+	bInventoryLoadPending = false;
+
+	UWorld* World = GetWorld();
+	URPGGameInstanceBase* GameInstance = World ? World->GetGameInstance<URPGGameInstanceBase>() : nullptr;
+	URPGSaveGame* CurrentSaveGame = GameInstance ? GameInstance->GetCurrentSaveGame() : nullptr;
+
+	if (CurrentSaveGame)
+	{
+		// Everything is in memory now, so this will not hitch
+		CopyInventoryFromSaveGame(CurrentSaveGame);
+	}
+
+	NotifyInventoryLoaded();
+}
+
+void ARPGPlayerControllerBase::MarkInventoryItemDirty(URPGItem* Item)
+{
+	// Resolve the id once per change, not once per save
+	if (Item && !DirtyItems.Contains(Item))
+	{
+		DirtyItems.Add(Item, Item->GetPrimaryAssetId());
+	}
+}
+
+void ARPGPlayerControllerBase::MarkSlotDirty(const FRPGItemSlot& ItemSlot)
+{
+	DirtySlots.Add(ItemSlot);
+}
+
+void ARPGPlayerControllerBase::AddToInventoryTypeIndex(URPGItem* Item, int32 RegistryIndex)
+{
+	if (Item)
+	{
+		InventoryItemsByType.FindOrAdd(Item->GetPrimaryAssetId().PrimaryAssetType).Add(Item);
+		InventoryRegistryIndices.Add(Item, RegistryIndex);
+	}
+}
+
+void ARPGPlayerControllerBase::RemoveFromInventoryTypeIndex(URPGItem* Item)
+{
+	if (Item)
+	{
+		TArray<URPGItem*>* FoundItems = InventoryItemsByType.Find(Item->GetPrimaryAssetId().PrimaryAssetType);
+
+		if (FoundItems)
+		{
+			// Keep the order items were added in, so UI lists stay stable
+			FoundItems->RemoveSingle(Item);
+		}
+		InventoryRegistryIndices.Remove(Item);
+	}
+}
+
+int32 ARPGPlayerControllerBase::GetInventoryRegistryIndex(URPGItem* Item) const
+{
+	const int32* FoundIndex = InventoryRegistryIndices.Find(Item);
+
+	if (FoundIndex)
+	{
+		return *FoundIndex;
+	}
+	return Item ? Item->GetRegistryIndex() : INDEX_NONE;
+}
+
+bool ARPGPlayerControllerBase::FillEmptySlotWithItem(URPGItem* NewItem)
+{
+	if (SlottedItems.FindItemSlot(NewItem).IsValid())
+	{
+		// Item is already slotted
+		return false;
+	}
+
+	// Look for the lowest empty item slot to fill with this item
+	FRPGItemSlot EmptySlot = SlottedItems.FindFreeSlot(NewItem->GetPrimaryAssetId().PrimaryAssetType);
+
 	if (EmptySlot.IsValid())
 	{
-		SlottedItems[EmptySlot] = NewItem;
+		SlottedItems.SetItem(EmptySlot, NewItem, GetInventoryRegistryIndex(NewItem));
+		MarkSlotDirty(EmptySlot);
 		NotifySlottedItemChanged(EmptySlot, NewItem);
 		return true;
 	}
@@ -368,6 +631,13 @@ bool ARPGPlayerControllerBase::FillEmptySlotWithItem(URPGItem* NewItem)
 
 void ARPGPlayerControllerBase::NotifyInventoryItemChanged(bool bAdded, URPGItem* Item)
 {
+	if (IsInInventoryTransaction())
+	{
+		// Merge with any earlier change to this item, the last one wins
+		PendingItemChanges.Add(Item, bAdded);
+		return;
+	}
+
 	// Notify native before blueprint
 	OnInventoryItemChangedNative.Broadcast(bAdded, Item);
 	OnInventoryItemChanged.Broadcast(bAdded, Item);
@@ -378,6 +648,12 @@ void ARPGPlayerControllerBase::NotifyInventoryItemChanged(bool bAdded, URPGItem*
 
 void ARPGPlayerControllerBase::NotifySlottedItemChanged(FRPGItemSlot ItemSlot, URPGItem* Item)
 {
+	if (IsInInventoryTransaction())
+	{
+		PendingSlotChanges.Add(ItemSlot);
+		return;
+	}
+
 	// Notify native before blueprint
 	OnSlottedItemChangedNative.Broadcast(ItemSlot, Item);
 	OnSlottedItemChanged.Broadcast(ItemSlot, Item);
@@ -2,11 +2,95 @@
 
 #include "RPGSaveGame.h"
 #include "RPGGameInstanceBase.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/Compression.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+namespace RPGSaveGameCompact
+{
+	/** Set in the flags byte if the payload is compressed */
+	static const uint8 Flag_Compressed = 1 << 0;
+
+	/** Largest uncompressed payload accepted when loading, far above any real inventory. The size comes from the file so it can't be trusted */
+	static const int32 MaxUncompressedSize = 64 * 1024 * 1024;
+
+	/** Builds the string table while writing, so every type and item name is only stored once */
+	struct FStringTableWriter
+	{
+		TArray<FString> Strings;
+		TMap<FName, uint32> StringIndices;
+
+		uint32 Intern(FName Name)
+		{
+			if (const uint32* FoundIndex = StringIndices.Find(Name))
+			{
+				return *FoundIndex;
+			}
+
+			const uint32 NewIndex = Strings.Add(Name.ToString());
+			StringIndices.Add(Name, NewIndex);
+			return NewIndex;
+		}
+	};
+
+	static void WriteInt(FArchive& Ar, int32 Value)
+	{
+		uint32 PackedValue = (uint32)FMath::Max(Value, 0);
+		Ar.SerializeIntPacked(PackedValue);
+	}
+
+	static int32 ReadInt(FArchive& Ar)
+	{
+		uint32 PackedValue = 0;
+		Ar.SerializeIntPacked(PackedValue);
+		return (int32)FMath::Min(PackedValue, (uint32)MAX_int32);
+	}
+
+	static bool ReadName(FArchive& Ar, const TArray<FName>& Names, FName& OutName)
+	{
+		const int32 Index = ReadInt(Ar);
+		if (!Names.IsValidIndex(Index))
+		{
+			Ar.SetError();
+			return false;
+		}
+		OutName = Names[Index];
+		return true;
+	}
+}
 
 void URPGSaveGame::Serialize(FArchive& Ar)
 {
+	// Reference collectors and memory counters only care about tagged properties
+	const bool bCompactInventory = InventoryFormat != ERPGSaveInventoryFormat::Tagged && !Ar.IsObjectReferenceCollector() && !Ar.IsCountingMemory();
+
+	if (Ar.IsSaving() && bCompactInventory)
+	{
+		// Keep the maps out of the tagged properties, they get written in compact form after them
+		TMap<FPrimaryAssetId, FRPGItemData> SavedInventoryData = MoveTemp(InventoryData);
+		TMap<FRPGItemSlot, FPrimaryAssetId> SavedSlottedItems = MoveTemp(SlottedItems);
+		InventoryData.Reset();
+		SlottedItems.Reset();
+
+		Super::Serialize(Ar);
+
+		InventoryData = MoveTemp(SavedInventoryData);
+		SlottedItems = MoveTemp(SavedSlottedItems);
+
+		SerializeCompactInventory(Ar);
+		return;
+	}
+
 	Super::Serialize(Ar);
 
+	// InventoryFormat was just read from the tagged properties, and is left at Tagged by older saves
+	if (Ar.IsLoading() && InventoryFormat != ERPGSaveInventoryFormat::Tagged && SavedDataVersion >= ERPGSaveGameVersion::AddedCompactInventory
+		&& !Ar.IsObjectReferenceCollector() && !Ar.IsCountingMemory())
+	{
+		SerializeCompactInventory(Ar);
+	}
+
 	if (Ar.IsLoading() && SavedDataVersion != ERPGSaveGameVersion::LatestVersion)
 	{
 		if (SavedDataVersion < ERPGSaveGameVersion::AddedItemData)
@@ -22,4 +106,209 @@ void URPGSaveGame::Serialize(FArchive& Ar)
 		
 		SavedDataVersion = ERPGSaveGameVersion::LatestVersion;
 	}
-}
\ No newline at end of file
+}
+
+void URPGSaveGame::SerializeCompactInventory(FArchive& Ar)
+{
+	using namespace RPGSaveGameCompact;
+
+	uint8 Flags = 0;
+	int32 UncompressedSize = 0;
+	TArray<uint8> Payload;
+
+	if (Ar.IsSaving())
+	{
+		FStringTableWriter StringTable;
+		TArray<uint8> Records;
+		FMemoryWriter RecordWriter(Records);
+
+		// Inventory is type, name, count, level
+		WriteInt(RecordWriter, InventoryData.Num());
+		for (const TPair<FPrimaryAssetId, FRPGItemData>& ItemPair : InventoryData)
+		{
+			WriteInt(RecordWriter, StringTable.Intern(ItemPair.Key.PrimaryAssetType.GetName()));
+			WriteInt(RecordWriter, StringTable.Intern(ItemPair.Key.PrimaryAssetName));
+			WriteInt(RecordWriter, ItemPair.Value.ItemCount);
+			WriteInt(RecordWriter, ItemPair.Value.ItemLevel);
+		}
+
+		// Slots are slot type, slot number, then item type and name. Empty slots store a name index of 0 and no type
+		WriteInt(RecordWriter, SlottedItems.Num());
+		for (const TPair<FRPGItemSlot, FPrimaryAssetId>& SlotPair : SlottedItems)
+		{
+			WriteInt(RecordWriter, StringTable.Intern(SlotPair.Key.ItemType.GetName()));
+			WriteInt(RecordWriter, SlotPair.Key.SlotNumber);
+
+			if (SlotPair.Value.IsValid())
+			{
+				WriteInt(RecordWriter, StringTable.Intern(SlotPair.Value.PrimaryAssetName) + 1);
+				WriteInt(RecordWriter, StringTable.Intern(SlotPair.Value.PrimaryAssetType.GetName()));
+			}
+			else
+			{
+				WriteInt(RecordWriter, 0);
+			}
+		}
+
+		// String table goes first so the reader can resolve indices as it goes
+		FMemoryWriter PayloadWriter(Payload);
+		WriteInt(PayloadWriter, StringTable.Strings.Num());
+		for (FString& String : StringTable.Strings)
+		{
+			PayloadWriter << String;
+		}
+		PayloadWriter.Serialize(Records.GetData(), Records.Num());
+
+		UncompressedSize = Payload.Num();
+
+		if (InventoryFormat == ERPGSaveInventoryFormat::CompactCompressed)
+		{
+			int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, UncompressedSize);
+			TArray<uint8> CompressedPayload;
+			CompressedPayload.SetNumUninitialized(CompressedSize);
+
+			if (FCompression::CompressMemory(NAME_Zlib, CompressedPayload.GetData(), CompressedSize, Payload.GetData(), UncompressedSize))
+			{
+				CompressedPayload.SetNum(CompressedSize);
+				Payload = MoveTemp(CompressedPayload);
+				Flags |= Flag_Compressed;
+			}
+		}
+	}
+
+	Ar << Flags;
+	Ar << UncompressedSize;
+	Ar << Payload;
+
+	if (Ar.IsLoading() && !Ar.IsError())
+	{
+		InventoryData.Reset();
+		SlottedItems.Reset();
+
+		if (Flags & Flag_Compressed)
+		{
+			if (UncompressedSize < 0 || UncompressedSize > MaxUncompressedSize)
+			{
+				UE_LOG(LogActionRPG, Warning, TEXT("Invalid inventory size %d in save game %s!"), UncompressedSize, *GetName());
+				Ar.SetError();
+				return;
+			}
+
+			TArray<uint8> UncompressedPayload;
+			UncompressedPayload.SetNumUninitialized(UncompressedSize);
+
+			if (!FCompression::UncompressMemory(NAME_Zlib, UncompressedPayload.GetData(), UncompressedSize, Payload.GetData(), Payload.Num()))
+			{
+				UE_LOG(LogActionRPG, Warning, TEXT("Failed to decompress inventory in save game %s!"), *GetName());
+				Ar.SetError();
+				return;
+			}
+			Payload = MoveTemp(UncompressedPayload);
+		}
+
+		FMemoryReader PayloadReader(Payload);
+
+		TArray<FName> Names;
+		const int32 NumStrings = ReadInt(PayloadReader);
+		for (int32 StringIndex = 0; StringIndex < NumStrings && !PayloadReader.IsError(); StringIndex++)
+		{
+			FString String;
+			PayloadReader << String;
+			Names.Add(FName(*String));
+		}
+
+		const int32 NumItems = ReadInt(PayloadReader);
+		for (int32 ItemIndex = 0; ItemIndex < NumItems && !PayloadReader.IsError(); ItemIndex++)
+		{
+			FName TypeName, ItemName;
+			if (ReadName(PayloadReader, Names, TypeName) && ReadName(PayloadReader, Names, ItemName))
+			{
+				const int32 ItemCount = ReadInt(PayloadReader);
+				const int32 ItemLevel = ReadInt(PayloadReader);
+				InventoryData.Add(FPrimaryAssetId(TypeName, ItemName), FRPGItemData(ItemCount, ItemLevel));
+			}
+		}
+
+		const int32 NumSlots = ReadInt(PayloadReader);
+		for (int32 SlotIndex = 0; SlotIndex < NumSlots && !PayloadReader.IsError(); SlotIndex++)
+		{
+			FName SlotTypeName;
+			if (!ReadName(PayloadReader, Names, SlotTypeName))
+			{
+				break;
+			}
+
+			const int32 SlotNumber = ReadInt(PayloadReader);
+			const int32 ItemNameIndex = ReadInt(PayloadReader);
+			FPrimaryAssetId ItemId;
+
+			if (ItemNameIndex > 0)
+			{
+				FName ItemTypeName;
+				if (!Names.IsValidIndex(ItemNameIndex - 1) || !ReadName(PayloadReader, Names, ItemTypeName))
+				{
+					PayloadReader.SetError();
+					break;
+				}
+				ItemId = FPrimaryAssetId(ItemTypeName, Names[ItemNameIndex - 1]);
+			}
+
+			SlottedItems.Add(FRPGItemSlot(SlotTypeName, SlotNumber), ItemId);
+		}
+
+		if (PayloadReader.IsError())
+		{
+			UE_LOG(LogActionRPG, Warning, TEXT("Inventory in save game %s is corrupt, some items were not loaded!"), *GetName());
+		}
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+/** Compares size and serialize time of every inventory format, for inventories of 10, 1k and 100k entries */
+static void BenchmarkSaveGameFormats(const TArray<FString>& Args)
+{
+	static const TCHAR* FormatNames[] = { TEXT("Tagged"), TEXT("Compact"), TEXT("CompactCompressed") };
+	static const FPrimaryAssetType ItemTypes[] = { URPGAssetManager::PotionItemType, URPGAssetManager::SkillItemType, URPGAssetManager::TokenItemType, URPGAssetManager::WeaponItemType };
+	const int32 NumSlotsPerType = 10;
+
+	for (int32 NumEntries : { 10, 1000, 100000 })
+	{
+		for (int32 FormatIndex = 0; FormatIndex < UE_ARRAY_COUNT(FormatNames); FormatIndex++)
+		{
+			URPGSaveGame* SaveGame = NewObject<URPGSaveGame>();
+			SaveGame->InventoryFormat = (ERPGSaveInventoryFormat)FormatIndex;
+
+			for (int32 EntryIndex = 0; EntryIndex < NumEntries; EntryIndex++)
+			{
+				const FPrimaryAssetId ItemId(ItemTypes[EntryIndex % UE_ARRAY_COUNT(ItemTypes)], FName(*FString::Printf(TEXT("Item_%d"), EntryIndex)));
+				SaveGame->InventoryData.Add(ItemId, FRPGItemData(EntryIndex % 99 + 1, EntryIndex % 10 + 1));
+
+				const FRPGItemSlot ItemSlot(ItemId.PrimaryAssetType, EntryIndex / UE_ARRAY_COUNT(ItemTypes));
+				if (ItemSlot.SlotNumber < NumSlotsPerType)
+				{
+					SaveGame->SlottedItems.Add(ItemSlot, ItemId);
+				}
+			}
+
+			TArray<uint8> SaveData;
+			const double SaveStartTime = FPlatformTime::Seconds();
+			UGameplayStatics::SaveGameToMemory(SaveGame, SaveData);
+			const double LoadStartTime = FPlatformTime::Seconds();
+			URPGSaveGame* LoadedGame = Cast<URPGSaveGame>(UGameplayStatics::LoadGameFromMemory(SaveData));
+			const double EndTime = FPlatformTime::Seconds();
+
+			const bool bMatches = LoadedGame && LoadedGame->InventoryData.Num() == SaveGame->InventoryData.Num() && LoadedGame->SlottedItems.Num() == SaveGame->SlottedItems.Num();
+
+			UE_LOG(LogActionRPG, Display, TEXT("SaveGame benchmark: %6d entries %-17s %10d bytes, save %8.3f ms, load %8.3f ms%s"),
+				NumEntries, FormatNames[FormatIndex], SaveData.Num(), (LoadStartTime - SaveStartTime) * 1000.0, (EndTime - LoadStartTime) * 1000.0, bMatches ? TEXT("") : TEXT(", MISMATCH!"));
+		}
+	}
+}
+
+static FAutoConsoleCommand BenchmarkSaveGameFormatsCommand(
+	TEXT("RPG.SaveGame.BenchmarkFormats"),
+	TEXT("Compares size and serialize/deserialize time of the save game inventory formats for 10, 1k and 100k entries"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkSaveGameFormats));
+
+#endif
@@ -0,0 +1,305 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "RPGSaveJournal.h"
+#include "RPGSaveGame.h"
+#include "Async/Async.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+void FRPGSaveJournalRecord::Apply(URPGSaveGame* SaveGame) const
+{
+	switch (Type)
+	{
+	case EType::SetItem:
+		SaveGame->InventoryData.Add(ItemId, ItemData);
+		break;
+	case EType::RemoveItem:
+		SaveGame->InventoryData.Remove(ItemId);
+		break;
+	case EType::SetSlot:
+		SaveGame->SlottedItems.Add(ItemSlot, ItemId);
+		break;
+	}
+}
+
+FArchive& operator<<(FArchive& Ar, FRPGSaveJournalRecord& Record)
+{
+	uint8 Type = (uint8)Record.Type;
+	FString ItemIdString = Ar.IsSaving() ? Record.ItemId.ToString() : FString();
+
+	Ar << Record.Sequence;
+	Ar << Type;
+	Ar << ItemIdString;
+
+	if (Ar.IsLoading())
+	{
+		Record.Type = (FRPGSaveJournalRecord::EType)Type;
+		Record.ItemId = FPrimaryAssetId::FromString(ItemIdString);
+	}
+
+	if (Record.Type == FRPGSaveJournalRecord::EType::SetItem)
+	{
+		Ar << Record.ItemData.ItemCount;
+		Ar << Record.ItemData.ItemLevel;
+	}
+	else if (Record.Type == FRPGSaveJournalRecord::EType::SetSlot)
+	{
+		FString SlotTypeString = Ar.IsSaving() ? Record.ItemSlot.ItemType.ToString() : FString();
+		Ar << SlotTypeString;
+		Ar << Record.ItemSlot.SlotNumber;
+
+		if (Ar.IsLoading())
+		{
+			Record.ItemSlot.ItemType = FPrimaryAssetType(*SlotTypeString);
+			Record.ItemSlot.RefreshNativeType();
+		}
+	}
+	return Ar;
+}
+
+FRPGSaveJournal::FRPGSaveJournal()
+	: NextSequence(1)
+	, CompactedSequence(0)
+{}
+
+FRPGSaveJournal::~FRPGSaveJournal()
+{
+	Close();
+}
+
+void FRPGSaveJournal::Open(const FString& SlotName, int32 UserIndex)
+{
+	Close();
+
+	FilePath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("SaveGames"), FString::Printf(TEXT("%s_%d.journal"), *SlotName, UserIndex));
+	PendingRecords.Reset();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString TempFilePath = GetTempFilePath();
+
+	if (PlatformFile.FileExists(*TempFilePath))
+	{
+		if (PlatformFile.FileExists(*FilePath))
+		{
+			// The rewrite was not swapped in, the journal still has every record
+			PlatformFile.DeleteFile(*TempFilePath);
+		}
+		else
+		{
+			// Stopped between removing the journal and moving the finished rewrite into place
+			UE_LOG(LogActionRPG, Log, TEXT("Recovered save journal %s from an interrupted compaction"), *FilePath);
+			PlatformFile.MoveFile(*FilePath, *TempFilePath);
+		}
+	}
+}
+
+void FRPGSaveJournal::Close()
+{
+	FinishCompaction(true);
+	FileHandle.Reset();
+}
+
+int32 FRPGSaveJournal::Replay(URPGSaveGame* SaveGame)
+{
+	TArray<FRPGSaveJournalRecord> Records;
+	ReadRecords(Records);
+
+	PendingRecords.Reset();
+	NextSequence = FMath::Max(NextSequence, SaveGame->JournalSequence + 1);
+
+	for (FRPGSaveJournalRecord& Record : Records)
+	{
+		// Anything at or below the snapshot sequence is already in the save game
+		if (Record.Sequence > SaveGame->JournalSequence)
+		{
+			Record.Apply(SaveGame);
+			NextSequence = FMath::Max(NextSequence, Record.Sequence + 1);
+			PendingRecords.Add(MoveTemp(Record));
+		}
+	}
+
+	if (PendingRecords.Num() > 0)
+	{
+		UE_LOG(LogActionRPG, Log, TEXT("Replayed %d inventory changes from save journal %s"), PendingRecords.Num(), *FilePath);
+	}
+	return PendingRecords.Num();
+}
+
+bool FRPGSaveJournal::Append(FRPGSaveJournalRecord& Record)
+{
+	if (FilePath.IsEmpty())
+	{
+		return false;
+	}
+
+	FinishCompaction(false);
+
+	if (!FileHandle)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FilePath));
+		FileHandle.Reset(PlatformFile.OpenWrite(*FilePath, true));
+
+		if (!FileHandle)
+		{
+			UE_LOG(LogActionRPG, Warning, TEXT("Failed to open save journal %s!"), *FilePath);
+			return false;
+		}
+	}
+
+	Record.Sequence = NextSequence++;
+	if (!WriteRecord(*FileHandle, Record))
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("Failed to write to save journal %s!"), *FilePath);
+		return false;
+	}
+
+	PendingRecords.Add(Record);
+	return true;
+}
+
+void FRPGSaveJournal::Compact(int64 SnapshotSequence)
+{
+	if (FilePath.IsEmpty())
+	{
+		return;
+	}
+
+	// Only one rewrite at a time
+	FinishCompaction(true);
+
+	PendingRecords.RemoveAll([SnapshotSequence](const FRPGSaveJournalRecord& Record)
+	{
+		return Record.Sequence <= SnapshotSequence;
+	});
+
+	// Records appended while this runs still go to the journal, they are copied over when the rewrite is swapped in
+	CompactedSequence = GetLastSequence();
+	CompactionResult = Async(EAsyncExecution::ThreadPool, [TempFilePath = GetTempFilePath(), Records = PendingRecords]() mutable
+	{
+		TUniquePtr<IFileHandle> TempHandle(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*TempFilePath));
+		if (!TempHandle)
+		{
+			return false;
+		}
+
+		bool bWritten = true;
+		for (FRPGSaveJournalRecord& Record : Records)
+		{
+			bWritten &= WriteRecord(*TempHandle, Record);
+		}
+		return bWritten;
+	});
+}
+
+FString FRPGSaveJournal::GetTempFilePath() const
+{
+	return FilePath + TEXT(".tmp");
+}
+
+void FRPGSaveJournal::FinishCompaction(bool bWait)
+{
+	if (!CompactionResult.IsValid() || (!bWait && !CompactionResult.IsReady()))
+	{
+		return;
+	}
+
+	bool bWritten = CompactionResult.Get();
+	CompactionResult.Reset();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString TempFilePath = GetTempFilePath();
+
+	if (bWritten)
+	{
+		TUniquePtr<IFileHandle> TempHandle(PlatformFile.OpenWrite(*TempFilePath, true));
+		bWritten = TempHandle.IsValid();
+
+		for (FRPGSaveJournalRecord& Record : PendingRecords)
+		{
+			if (bWritten && Record.Sequence > CompactedSequence)
+			{
+				bWritten = WriteRecord(*TempHandle, Record);
+			}
+		}
+	}
+
+	if (!bWritten)
+	{
+		// The journal still has every record, it just stays longer until the next compaction
+		UE_LOG(LogActionRPG, Warning, TEXT("Failed to compact save journal %s!"), *FilePath);
+		PlatformFile.DeleteFile(*TempFilePath);
+		return;
+	}
+
+	// If this stops between the delete and the move, Open moves the rewrite into place
+	FileHandle.Reset();
+	PlatformFile.DeleteFile(*FilePath);
+	PlatformFile.MoveFile(*FilePath, *TempFilePath);
+}
+
+void FRPGSaveJournal::Reset()
+{
+	Close();
+	PendingRecords.Reset();
+
+	if (!FilePath.IsEmpty())
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		PlatformFile.DeleteFile(*FilePath);
+		PlatformFile.DeleteFile(*GetTempFilePath());
+	}
+}
+
+bool FRPGSaveJournal::WriteRecord(IFileHandle& Handle, FRPGSaveJournalRecord& Record)
+{
+	TArray<uint8> Payload;
+	FMemoryWriter PayloadWriter(Payload);
+	PayloadWriter << Record;
+
+	uint32 Header[2] = { (uint32)Payload.Num(), FCrc::MemCrc32(Payload.GetData(), Payload.Num()) };
+
+	const bool bWritten = Handle.Write((const uint8*)Header, sizeof(Header)) && Handle.Write(Payload.GetData(), Payload.Num());
+	Handle.Flush();
+	return bWritten;
+}
+
+bool FRPGSaveJournal::ReadRecords(TArray<FRPGSaveJournalRecord>& OutRecords) const
+{
+	TArray<uint8> FileData;
+	if (FilePath.IsEmpty() || !FFileHelper::LoadFileToArray(FileData, *FilePath, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	int32 Offset = 0;
+	while (Offset + (int32)sizeof(uint32) * 2 <= FileData.Num())
+	{
+		uint32 Header[2];
+		FMemory::Memcpy(Header, FileData.GetData() + Offset, sizeof(Header));
+		Offset += sizeof(Header);
+
+		const int32 PayloadSize = (int32)Header[0];
+		if (PayloadSize < 0 || Offset + PayloadSize > FileData.Num() || FCrc::MemCrc32(FileData.GetData() + Offset, PayloadSize) != Header[1])
+		{
+			// The last write was cut off, everything before it is still good
+			UE_LOG(LogActionRPG, Warning, TEXT("Save journal %s ends with a damaged record, it was ignored"), *FilePath);
+			break;
+		}
+
+		TArrayView<const uint8> Payload(FileData.GetData() + Offset, PayloadSize);
+		FMemoryReaderView PayloadReader(Payload);
+		FRPGSaveJournalRecord Record;
+		PayloadReader << Record;
+
+		if (!PayloadReader.IsError())
+		{
+			OutRecords.Add(MoveTemp(Record));
+		}
+		Offset += PayloadSize;
+	}
+	return true;
+}
@@ -0,0 +1,339 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "RPGSaveService.h"
+#include "RPGGameInstanceBase.h"
+#include "RPGSaveGame.h"
+#include "Kismet/GameplayStatics.h"
+#include "PlatformFeatures.h"
+#include "SaveGameSystem.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+
+static int32 GRPGSaveServiceMaxConcurrentOperations = 4;
+static FAutoConsoleVariableRef CVarRPGSaveServiceMaxConcurrentOperations(
+	TEXT("RPG.SaveService.MaxConcurrentOperations"),
+	GRPGSaveServiceMaxConcurrentOperations,
+	TEXT("Maximum number of save game reads and writes the save service runs on workers at the same time"));
+
+void URPGSaveService::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	RunningOperations = 0;
+	Stats = FRPGSaveServiceStats();
+	TotalReadLatency = 0.0;
+	TotalWriteLatency = 0.0;
+}
+
+void URPGSaveService::Deinitialize()
+{
+	for (TPair<FString, FUserState>& Pair : UserStates)
+	{
+		FUserState& State = Pair.Value;
+
+		if (State.bRunning)
+		{
+			// Let the worker finish, its game thread callback is ignored once the state is gone
+			State.Task.Wait();
+			State.Operations.RemoveAt(0);
+		}
+
+		// There won't be another frame to run queued writes in, and a single write stores the latest state
+		URPGSaveGame* SaveGame = UserSaveGames.FindRef(Pair.Key);
+		if (SaveGame && State.Operations.ContainsByPredicate([](const FSaveOperation& Operation) { return Operation.bWrite; }))
+		{
+			UGameplayStatics::SaveGameToSlot(SaveGame, GetUserSlotName(Pair.Key), 0);
+		}
+	}
+
+	UserStates.Reset();
+	ReadyUsers.Reset();
+	UserSaveGames.Reset();
+	RunningOperations = 0;
+
+	Super::Deinitialize();
+}
+
+void URPGSaveService::LoadUserSaveGame(const FString& UserId)
+{
+	if (UserId.IsEmpty())
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("LoadUserSaveGame: Called with an empty user id!"));
+		return;
+	}
+
+	QueueOperation(UserId, false);
+}
+
+URPGSaveGame* URPGSaveService::GetUserSaveGame(const FString& UserId) const
+{
+	return UserSaveGames.FindRef(UserId);
+}
+
+bool URPGSaveService::WriteUserSaveGame(const FString& UserId)
+{
+	if (!UserSaveGames.Contains(UserId))
+	{
+		// Must be loaded first
+		return false;
+	}
+
+	QueueOperation(UserId, true);
+	return true;
+}
+
+void URPGSaveService::ReleaseUser(const FString& UserId)
+{
+	if (!WriteUserSaveGame(UserId) && !UserStates.Contains(UserId))
+	{
+		return;
+	}
+
+	FUserState& State = UserStates.FindOrAdd(UserId);
+	State.bReleased = true;
+
+	if (State.Operations.Num() == 0)
+	{
+		UserStates.Remove(UserId);
+		UserSaveGames.Remove(UserId);
+	}
+}
+
+FRPGSaveServiceStats URPGSaveService::GetStats() const
+{
+	FRPGSaveServiceStats Result = Stats;
+
+	Result.QueueDepth = 0;
+	for (const TPair<FString, FUserState>& Pair : UserStates)
+	{
+		Result.QueueDepth += Pair.Value.Operations.Num() - (Pair.Value.bRunning ? 1 : 0);
+	}
+	Result.InFlight = RunningOperations;
+	Result.AverageReadLatency = Stats.ReadsCompleted > 0 ? (float)(TotalReadLatency / Stats.ReadsCompleted) : 0.0f;
+	Result.AverageWriteLatency = Stats.WritesCompleted > 0 ? (float)(TotalWriteLatency / Stats.WritesCompleted) : 0.0f;
+
+	return Result;
+}
+
+FString URPGSaveService::GetUserSlotName(const FString& UserId) const
+{
+	const URPGGameInstanceBase* GameInstance = Cast<URPGGameInstanceBase>(GetGameInstance());
+	const FString SlotPrefix = GameInstance ? GameInstance->SaveSlot : FString(TEXT("SaveGame"));
+
+	return FString::Printf(TEXT("%s_%s"), *SlotPrefix, *FPaths::MakeValidFileName(UserId, TEXT('_')));
+}
+
+void URPGSaveService::QueueOperation(const FString& UserId, bool bWrite)
+{
+	FUserState& State = UserStates.FindOrAdd(UserId);
+	State.bReleased = false;
+
+	if (bWrite)
+	{
+		// A write that has not started yet serializes the latest state when it does
+		const int32 NumWaiting = State.Operations.Num() - (State.bRunning ? 1 : 0);
+		if (NumWaiting > 0 && State.Operations.Last().bWrite)
+		{
+			Stats.WritesCoalesced++;
+			return;
+		}
+	}
+
+	const bool bWasIdle = State.Operations.Num() == 0;
+
+	FSaveOperation Operation;
+	Operation.bWrite = bWrite;
+	Operation.RequestTime = FPlatformTime::Seconds();
+	State.Operations.Add(Operation);
+
+	if (bWasIdle)
+	{
+		ReadyUsers.Add(UserId);
+	}
+
+	DispatchOperations();
+}
+
+void URPGSaveService::DispatchOperations()
+{
+	const int32 MaxOperations = FMath::Max(1, GRPGSaveServiceMaxConcurrentOperations);
+
+	while (RunningOperations < MaxOperations && ReadyUsers.Num() > 0)
+	{
+		const FString UserId = ReadyUsers[0];
+		ReadyUsers.RemoveAt(0);
+
+		FUserState* State = UserStates.Find(UserId);
+		if (State && !State->bRunning && State->Operations.Num() > 0)
+		{
+			StartOperation(UserId, *State);
+		}
+	}
+}
+
+void URPGSaveService::StartOperation(const FString& UserId, FUserState& State)
+{
+	ISaveGameSystem* SaveSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
+	const FString SlotName = GetUserSlotName(UserId);
+	TWeakObjectPtr<URPGSaveService> WeakThis(this);
+
+	State.bRunning = true;
+	RunningOperations++;
+
+	if (State.Operations[0].bWrite)
+	{
+		// Serialize here so the worker only touches bytes
+		TArray<uint8> SaveData;
+		URPGSaveGame* SaveGame = UserSaveGames.FindRef(UserId);
+		if (SaveGame)
+		{
+			UGameplayStatics::SaveGameToMemory(SaveGame, SaveData);
+		}
+
+		State.Task = Async(EAsyncExecution::ThreadPool, [WeakThis, UserId, SlotName, SaveSystem, SaveData = MoveTemp(SaveData)]()
+		{
+			const bool bSuccess = SaveSystem && SaveData.Num() > 0 && SaveSystem->SaveGame(false, *SlotName, 0, SaveData);
+
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, UserId, bSuccess]()
+			{
+				if (URPGSaveService* SaveService = WeakThis.Get())
+				{
+					SaveService->HandleOperationFinished(UserId, bSuccess, TArray<uint8>());
+				}
+			});
+		});
+	}
+	else
+	{
+		State.Task = Async(EAsyncExecution::ThreadPool, [WeakThis, UserId, SlotName, SaveSystem]()
+		{
+			// A missing save is not a failure, the user is new. An existing slot that reads no data is
+			TArray<uint8> LoadedData;
+			bool bSuccess = SaveSystem != nullptr;
+			if (SaveSystem && SaveSystem->DoesSaveGameExist(*SlotName, 0))
+			{
+				bSuccess = SaveSystem->LoadGame(false, *SlotName, 0, LoadedData) && LoadedData.Num() > 0;
+			}
+
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, UserId, bSuccess, LoadedData = MoveTemp(LoadedData)]()
+			{
+				if (URPGSaveService* SaveService = WeakThis.Get())
+				{
+					SaveService->HandleOperationFinished(UserId, bSuccess, LoadedData);
+				}
+			});
+		});
+	}
+}
+
+void URPGSaveService::HandleOperationFinished(const FString& UserId, bool bSuccess, const TArray<uint8>& LoadedData)
+{
+	FUserState* State = UserStates.Find(UserId);
+	if (!State || !State->bRunning)
+	{
+		// Service was shut down while the worker was running
+		return;
+	}
+
+	const FSaveOperation Operation = State->Operations[0];
+	State->Operations.RemoveAt(0);
+	State->bRunning = false;
+	State->Task = TFuture<void>();
+	RunningOperations--;
+
+	const double Latency = FPlatformTime::Seconds() - Operation.RequestTime;
+
+	if (!bSuccess)
+	{
+		Stats.Failures++;
+		UE_LOG(LogActionRPG, Warning, TEXT("Save service failed to %s save game for user %s!"), Operation.bWrite ? TEXT("write") : TEXT("read"), *UserId);
+	}
+
+	if (Operation.bWrite)
+	{
+		Stats.WritesCompleted++;
+		TotalWriteLatency += Latency;
+		Stats.MaxWriteLatency = FMath::Max(Stats.MaxWriteLatency, (float)Latency);
+	}
+	else
+	{
+		Stats.ReadsCompleted++;
+		TotalReadLatency += Latency;
+		Stats.MaxReadLatency = FMath::Max(Stats.MaxReadLatency, (float)Latency);
+
+		HandleUserRead(UserId, bSuccess, LoadedData);
+	}
+
+	// Load callbacks may have queued or released, so look the state up again
+	State = UserStates.Find(UserId);
+	if (State)
+	{
+		if (State->Operations.Num() > 0)
+		{
+			ReadyUsers.Add(UserId);
+		}
+		else if (State->bReleased)
+		{
+			UserStates.Remove(UserId);
+			UserSaveGames.Remove(UserId);
+		}
+	}
+
+	DispatchOperations();
+}
+
+void URPGSaveService::HandleUserRead(const FString& UserId, bool bSuccess, const TArray<uint8>& LoadedData)
+{
+	URPGGameInstanceBase* GameInstance = Cast<URPGGameInstanceBase>(GetGameInstance());
+	URPGSaveGame* SaveGame = nullptr;
+
+	if (bSuccess && LoadedData.Num() > 0)
+	{
+		SaveGame = Cast<URPGSaveGame>(UGameplayStatics::LoadGameFromMemory(LoadedData));
+
+		if (!SaveGame)
+		{
+			Stats.Failures++;
+			UE_LOG(LogActionRPG, Warning, TEXT("Save service could not deserialize save game for user %s!"), *UserId);
+			bSuccess = false;
+		}
+	}
+
+	if (!bSuccess)
+	{
+		// The slot may still hold the player's data, a new save here would overwrite it on the next write. Any save game already hosted is kept
+		OnUserSaveGameLoaded.Broadcast(UserId, nullptr);
+		OnUserSaveGameLoadedNative.Broadcast(UserId, nullptr);
+		return;
+	}
+
+	if (SaveGame)
+	{
+		if (GameInstance)
+		{
+			// Make sure it has any newly added default inventory
+			GameInstance->AddDefaultInventory(SaveGame, false);
+		}
+	}
+	else
+	{
+		SaveGame = Cast<URPGSaveGame>(UGameplayStatics::CreateSaveGameObject(URPGSaveGame::StaticClass()));
+
+		if (GameInstance)
+		{
+			GameInstance->AddDefaultInventory(SaveGame, true);
+		}
+	}
+
+	if (GameInstance)
+	{
+		SaveGame->InventoryFormat = GameInstance->SaveInventoryFormat;
+	}
+	SaveGame->UserId = UserId;
+
+	UserSaveGames.Add(UserId, SaveGame);
+
+	OnUserSaveGameLoaded.Broadcast(UserId, SaveGame);
+	OnUserSaveGameLoadedNative.Broadcast(UserId, SaveGame);
+}
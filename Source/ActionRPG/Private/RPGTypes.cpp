@@ -0,0 +1,168 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "RPGTypes.h"
+#include "Items/RPGItem.h"
+
+ERPGItemType RPGItemTypes::FromAssetType(const FPrimaryAssetType& ItemType)
+{
+	static const FName TypeNames[] = { NAME_None, GetName(ERPGItemType::Potion), GetName(ERPGItemType::Skill), GetName(ERPGItemType::Token), GetName(ERPGItemType::Weapon) };
+	static_assert(UE_ARRAY_COUNT(TypeNames) == (int32)ERPGItemType::Count, "TypeNames must have an entry for every ERPGItemType");
+
+	const FName TypeName = ItemType.GetName();
+	for (int32 TypeIndex = 1; TypeIndex < (int32)ERPGItemType::Count; TypeIndex++)
+	{
+		if (TypeNames[TypeIndex] == TypeName)
+		{
+			return (ERPGItemType)TypeIndex;
+		}
+	}
+	return ERPGItemType::Unknown;
+}
+
+void FRPGItemSlotTable::Initialize(const TMap<FPrimaryAssetType, int32>& SlotsPerType)
+{
+	Reset();
+
+	for (const TPair<FPrimaryAssetType, int32>& Pair : SlotsPerType)
+	{
+		if (Pair.Key.IsValid() && Pair.Value > 0)
+		{
+			FRPGItemSlotArray& SlotArray = SlotsByType.Add(Pair.Key);
+			SlotArray.Items.SetNumZeroed(Pair.Value);
+			SlotArray.RegistryIndices.Init(INDEX_NONE, Pair.Value);
+			SlotArray.FreeSlots.Init(true, Pair.Value);
+			SlotArray.NativeType = RPGItemTypes::FromAssetType(Pair.Key);
+		}
+	}
+}
+
+void FRPGItemSlotTable::Reset()
+{
+	SlotsByType.Reset();
+	ItemToSlot.Reset();
+}
+
+bool FRPGItemSlotTable::IsValidSlot(const FRPGItemSlot& ItemSlot) const
+{
+	const FRPGItemSlotArray* SlotArray = SlotsByType.Find(ItemSlot.ItemType);
+
+	return SlotArray && SlotArray->Items.IsValidIndex(ItemSlot.SlotNumber);
+}
+
+URPGItem* FRPGItemSlotTable::GetItem(const FRPGItemSlot& ItemSlot) const
+{
+	const FRPGItemSlotArray* SlotArray = SlotsByType.Find(ItemSlot.ItemType);
+
+	if (SlotArray && SlotArray->Items.IsValidIndex(ItemSlot.SlotNumber))
+	{
+		return SlotArray->Items[ItemSlot.SlotNumber];
+	}
+	return nullptr;
+}
+
+int32 FRPGItemSlotTable::GetRegistryIndex(const FRPGItemSlot& ItemSlot) const
+{
+	const FRPGItemSlotArray* SlotArray = SlotsByType.Find(ItemSlot.ItemType);
+
+	if (SlotArray && SlotArray->RegistryIndices.IsValidIndex(ItemSlot.SlotNumber))
+	{
+		return SlotArray->RegistryIndices[ItemSlot.SlotNumber];
+	}
+	return INDEX_NONE;
+}
+
+bool FRPGItemSlotTable::SetItem(const FRPGItemSlot& ItemSlot, URPGItem* Item, int32 RegistryIndex)
+{
+	FRPGItemSlotArray* SlotArray = SlotsByType.Find(ItemSlot.ItemType);
+
+	if (!SlotArray || !SlotArray->Items.IsValidIndex(ItemSlot.SlotNumber))
+	{
+		return false;
+	}
+
+	URPGItem* OldItem = SlotArray->Items[ItemSlot.SlotNumber];
+	if (OldItem == Item)
+	{
+		return true;
+	}
+
+	if (OldItem)
+	{
+		ItemToSlot.Remove(OldItem);
+	}
+
+	if (Item)
+	{
+		// Items can only be in one slot, so empty the old one and keep its index
+		FRPGItemSlot* OldSlot = ItemToSlot.Find(Item);
+
+		if (OldSlot)
+		{
+			FRPGItemSlotArray& OldSlotArray = SlotsByType[OldSlot->ItemType];
+
+			if (RegistryIndex == INDEX_NONE)
+			{
+				RegistryIndex = OldSlotArray.RegistryIndices[OldSlot->SlotNumber];
+			}
+			WriteSlot(OldSlotArray, OldSlot->SlotNumber, nullptr, INDEX_NONE);
+			*OldSlot = ItemSlot;
+		}
+		else
+		{
+			ItemToSlot.Add(Item, ItemSlot);
+		}
+	}
+
+	if (Item && RegistryIndex == INDEX_NONE)
+	{
+		RegistryIndex = Item->GetRegistryIndex();
+	}
+
+	WriteSlot(*SlotArray, ItemSlot.SlotNumber, Item, Item ? RegistryIndex : INDEX_NONE);
+	return true;
+}
+
+FRPGItemSlot FRPGItemSlotTable::FindItemSlot(const URPGItem* Item) const
+{
+	const FRPGItemSlot* FoundSlot = ItemToSlot.Find(const_cast<URPGItem*>(Item));
+
+	if (FoundSlot)
+	{
+		return *FoundSlot;
+	}
+	return FRPGItemSlot();
+}
+
+FRPGItemSlot FRPGItemSlotTable::FindFreeSlot(const FPrimaryAssetType& ItemType) const
+{
+	const FRPGItemSlotArray* SlotArray = SlotsByType.Find(ItemType);
+
+	if (SlotArray)
+	{
+		// Lowest set bit is the lowest empty slot
+		const int32 FreeSlot = SlotArray->FreeSlots.Find(true);
+
+		if (FreeSlot != INDEX_NONE)
+		{
+			return FRPGItemSlot(ItemType, SlotArray->NativeType, FreeSlot);
+		}
+	}
+	return FRPGItemSlot();
+}
+
+int32 FRPGItemSlotTable::Num() const
+{
+	int32 NumSlots = 0;
+	for (const TPair<FPrimaryAssetType, FRPGItemSlotArray>& Pair : SlotsByType)
+	{
+		NumSlots += Pair.Value.Items.Num();
+	}
+	return NumSlots;
+}
+
+void FRPGItemSlotTable::WriteSlot(FRPGItemSlotArray& SlotArray, int32 SlotNumber, URPGItem* Item, int32 RegistryIndex)
+{
+	SlotArray.Items[SlotNumber] = Item;
+	SlotArray.RegistryIndices[SlotNumber] = RegistryIndex;
+	SlotArray.FreeSlots[SlotNumber] = (Item == nullptr);
+}
@@ -0,0 +1,57 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ActionRPG.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "GameplayEffect.h"
+#include "UObject/ObjectKey.h"
+#include "RPGAbilityGrantSubsystem.generated.h"
+
+class URPGGameplayAbility;
+
+/**
+ * Startup abilities and passive effects of one character class at one level, prepared once and shared by every instance
+ * The passive effect specs have no context, URPGAbilitySystemComponent::ApplyGrantTemplate gives each instance its own
+ */
+struct ACTIONRPG_API FRPGAbilityGrantTemplate
+{
+	/** Level the abilities are granted at and the effects were built for */
+	int32 Level;
+
+	/** Abilities to grant, in the order of the class's GameplayAbilities */
+	TArray<TSubclassOf<URPGGameplayAbility>> Abilities;
+
+	/** Passive effect specs with their definitions, tags and capture definitions already set up */
+	TArray<FGameplayEffectSpec> PassiveEffects;
+};
+
+/** Caches grant templates per character class and level, so waves of identical enemies don't repeat the same setup */
+UCLASS()
+class ACTIONRPG_API URPGAbilityGrantSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Subsystem overrides
+	virtual void Deinitialize() override;
+
+	/** Returns true if characters should be initialized from templates, controlled by RPG.Abilities.UseGrantTemplates */
+	static bool AreTemplatesEnabled();
+
+	/**
+	 * Returns the template for a character class and level, building it the first time
+	 * Abilities and PassiveEffects must be the class defaults, as they are only read when the template is built
+	 */
+	TSharedRef<const FRPGAbilityGrantTemplate> FindOrCreateTemplate(const UClass* CharacterClass, int32 Level, const TArray<TSubclassOf<URPGGameplayAbility>>& Abilities, const TArray<TSubclassOf<UGameplayEffect>>& PassiveEffects);
+
+	/** Drops every cached template, they are rebuilt on next use */
+	void ResetTemplates();
+
+	/** Returns the number of cached templates */
+	int32 GetNumTemplates() const;
+
+protected:
+	/** Cached templates, keyed by character class and level */
+	TMap<TPair<TObjectKey<UClass>, int32>, TSharedRef<const FRPGAbilityGrantTemplate>> Templates;
+};
@@ -8,6 +8,7 @@
 #include "RPGAbilitySystemComponent.generated.h"
 
 class URPGGameplayAbility;
+struct FRPGAbilityGrantTemplate;
 
 /**
  * Subclass of ability system component with game-specific data
@@ -21,14 +22,79 @@ class ACTIONRPG_API URPGAbilitySystemComponent : public UAbilitySystemComponent
 public:
 	// Constructors and overrides
 	URPGAbilitySystemComponent();
+	virtual void InitializeComponent() override;
 
 	/** Returns a list of currently active ability instances that match the tags */
 	void GetActiveAbilitiesWithTags(const FGameplayTagContainer& GameplayTagContainer, TArray<URPGGameplayAbility*>& ActiveAbilities);
 
+	/**
+	 * Calls Visitor for each active ability instance whose ability has all the tags, without allocating
+	 * Abilities given or removed by Visitor are only added or removed once the iteration is done
+	 */
+	void ForEachActiveAbilityWithTags(const FGameplayTagContainer& GameplayTagContainer, TFunctionRef<void(URPGGameplayAbility*)> Visitor);
+
+	/** Calls Visitor for each instance of a spec that is a URPGGameplayAbility, without copying the instance lists */
+	static void ForEachAbilityInstance(const FGameplayAbilitySpec& Spec, TFunctionRef<void(URPGGameplayAbility*)> Visitor);
+
 	/** Returns the default level used for ability activations, derived from the character */
 	int32 GetDefaultAbilityLevel() const;
 
+	/** Grants the abilities and applies the passive effects of a template in one pass, the effects share a single context with SourceObject */
+	void ApplyGrantTemplate(const FRPGAbilityGrantTemplate& GrantTemplate, UObject* SourceObject, TArray<FActiveGameplayEffectHandle>& OutPassiveEffectHandles);
+
+	/** Returns true if the tag is tracked by the cooldown table, which is any tag under Cooldown */
+	bool IsCooldownTag(const FGameplayTag& Tag) const;
+
+	/**
+	 * Looks up the active effect with the most time left that has any of the tags, using the cooldown table
+	 * Every tag must pass IsCooldownTag. Returns false if none of the tags are on an active effect
+	 */
+	bool GetCooldownRemaining(const FGameplayTagContainer& CooldownTags, float& TimeRemaining, float& CooldownDuration) const;
+
 	/** Version of function in AbilitySystemGlobals that returns correct type */
 	static URPGAbilitySystemComponent* GetAbilitySystemComponentFromActor(const AActor* Actor, bool LookForComponent = false);
 
+protected:
+	// Ability list overrides
+	virtual void OnGiveAbility(FGameplayAbilitySpec& AbilitySpec) override;
+	virtual void OnRemoveAbility(FGameplayAbilitySpec& AbilitySpec) override;
+
+	/** Indices into the activatable abilities for each ability tag and its parents */
+	TMap<FGameplayTag, TArray<int32>> AbilityTagIndex;
+
+	/** Number of specs when AbilityTagIndex was built */
+	int32 AbilityTagIndexSpecNum;
+
+	/** Set when abilities are given or removed, the index is rebuilt on the next lookup */
+	bool bAbilityTagIndexDirty;
+
+	/** Rebuilds AbilityTagIndex if the ability list changed since it was built */
+	void UpdateAbilityTagIndex();
+
+	/** Timing of one active effect in the cooldown table */
+	struct FCooldownEntry
+	{
+		FActiveGameplayEffectHandle Handle;
+		float StartWorldTime;
+		float Duration;
+	};
+
+	/** Root of the tags that are tracked by the cooldown table */
+	FGameplayTag CooldownRootTag;
+
+	/** Active effects per cooldown tag, effects are listed under their tags and all their parents so lookups match like MatchAnyOwningTags */
+	TMap<FGameplayTag, TArray<FCooldownEntry, TInlineAllocator<2>>> CooldownTable;
+
+	/** Tags each effect in the table is listed under, so it can be removed */
+	TMap<FActiveGameplayEffectHandle, FGameplayTagContainer> CooldownEffectTags;
+
+	/** Effect callbacks that keep the cooldown table up to date */
+	void HandleCooldownEffectAdded(UAbilitySystemComponent* Target, const FGameplayEffectSpec& Spec, FActiveGameplayEffectHandle ActiveHandle);
+	void HandleCooldownEffectRemoved(const FActiveGameplayEffect& ActiveEffect);
+	void HandleCooldownEffectStackChanged(FActiveGameplayEffectHandle ActiveHandle, int32 NewStackCount, int32 PreviousStackCount);
+	void HandleCooldownEffectTimeChanged(FActiveGameplayEffectHandle ActiveHandle, float NewStartTime, float NewDuration);
+
+	/** Copies the start time and duration of an active effect into its cooldown table entries */
+	void UpdateCooldownEntries(FActiveGameplayEffectHandle ActiveHandle, float StartWorldTime, float Duration);
+
 };
\ No newline at end of file
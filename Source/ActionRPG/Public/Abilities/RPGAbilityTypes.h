@@ -17,6 +17,79 @@ class URPGAbilitySystemComponent;
 class UGameplayEffect;
 class URPGTargetType;
 
+/** The parts of a hit result that effects and cues use, a fraction of the size of FHitResult */
+USTRUCT(BlueprintType)
+struct FRPGCompactHit
+{
+	GENERATED_BODY()
+
+public:
+	FRPGCompactHit() {}
+	explicit FRPGCompactHit(const FHitResult& HitResult);
+
+	/** Actor that was hit */
+	UPROPERTY(BlueprintReadOnly, Category = Targeting)
+	TWeakObjectPtr<AActor> Actor;
+
+	/** Location of the impact */
+	UPROPERTY(BlueprintReadOnly, Category = Targeting)
+	FVector_NetQuantize Location;
+
+	/** Normal of the hit surface */
+	UPROPERTY(BlueprintReadOnly, Category = Targeting)
+	FVector_NetQuantizeNormal Normal;
+
+	/** Bone that was hit, if the target is a skeletal mesh */
+	UPROPERTY(BlueprintReadOnly, Category = Targeting)
+	FName BoneName;
+
+	/** Returns a blocking hit result with these values, for adding to an effect context */
+	FHitResult ToHitResult() const;
+};
+
+/**
+ * Target data holding every hit of one targeting pass in a single array, instead of one FGameplayAbilityTargetData_SingleTargetHit per hit
+ * Allocate it with Allocate, which reuses data released by earlier targeting passes
+ * The engine applies effects through GetActors and does not know about the hits, FRPGGameplayEffectContainerSpec::ApplyEffectSpecToTargets applies them with one hit result per target
+ */
+USTRUCT()
+struct ACTIONRPG_API FRPGGameplayAbilityTargetData_MultiHit : public FGameplayAbilityTargetData
+{
+	GENERATED_BODY()
+
+public:
+	FRPGGameplayAbilityTargetData_MultiHit() {}
+
+	/** Hits in the order they were added */
+	UPROPERTY()
+	TArray<FRPGCompactHit> Hits;
+
+	/** Returns empty target data from the pool, it goes back to the pool when the last reference is released */
+	static TSharedRef<FRPGGameplayAbilityTargetData_MultiHit> Allocate();
+
+	/** Applies the spec to the actor of each hit, with the hit in the context of its copy of the spec */
+	TArray<FActiveGameplayEffectHandle> ApplyGameplayEffectSpecToHits(FGameplayEffectSpec& Spec, FPredictionKey PredictionKey = FPredictionKey()) const;
+
+	// FGameplayAbilityTargetData interface
+	virtual TArray<TWeakObjectPtr<AActor>> GetActors() const override;
+	virtual UScriptStruct* GetScriptStruct() const override;
+	virtual FString ToString() const override;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+private:
+	/** Deleter of pooled data */
+	static void Release(FRPGGameplayAbilityTargetData_MultiHit* Data);
+};
+
+template<>
+struct TStructOpsTypeTraits<FRPGGameplayAbilityTargetData_MultiHit> : public TStructOpsTypeTraitsBase2<FRPGGameplayAbilityTargetData_MultiHit>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
 
 /**
  * Struct defining a list of gameplay effects, a tag, and targeting info
@@ -64,4 +137,7 @@ public:
 
 	/** Adds new targets to target data */
 	void AddTargets(const TArray<FHitResult>& HitResults, const TArray<AActor*>& TargetActors);
+
+	/** Applies an effect spec to every target, returns the handles of the applied effects */
+	TArray<FActiveGameplayEffectHandle> ApplyEffectSpecToTargets(FGameplayEffectSpec& Spec, FPredictionKey PredictionKey = FPredictionKey()) const;
 };
@@ -14,6 +14,37 @@
 	GAMEPLAYATTRIBUTE_VALUE_SETTER(PropertyName) \
 	GAMEPLAYATTRIBUTE_VALUE_INITTER(PropertyName)
 
+/**
+ * Health, Mana and MoveSpeed as sent to simulated proxies, when RPG.Attributes.QuantizeProxyVitals is set
+ * Values are sent as packed tenths, and a current value equal to its base value only costs a bit
+ */
+USTRUCT()
+struct ACTIONRPG_API FRPGQuantizedVitals
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FGameplayAttributeData Health;
+
+	UPROPERTY()
+	FGameplayAttributeData Mana;
+
+	UPROPERTY()
+	FGameplayAttributeData MoveSpeed;
+
+	/** Writes or reads the quantized values */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FRPGQuantizedVitals> : public TStructOpsTypeTraitsBase2<FRPGQuantizedVitals>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
 /** This holds all of the attributes used by abilities, it instantiates a copy of this on every character */
 UCLASS()
 class ACTIONRPG_API URPGAttributeSet : public UAttributeSet
@@ -25,6 +56,8 @@ public:
 	URPGAttributeSet();
 	virtual void PreAttributeChange(const FGameplayAttribute& Attribute, float& NewValue) override;
 	virtual void PostGameplayEffectExecute(const FGameplayEffectModCallbackData& Data) override;
+	virtual void PostAttributeChange(const FGameplayAttribute& Attribute, float OldValue, float NewValue) override;
+	virtual void PostAttributeBaseChange(const FGameplayAttribute& Attribute, float OldValue, float NewValue) const override;
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
 	/** Current Health, when 0 we expect owner to die. Capped by MaxHealth */
@@ -67,7 +100,23 @@ public:
 	FGameplayAttributeData Damage;
 	ATTRIBUTE_ACCESSORS(URPGAttributeSet, Damage)
 
+	/** Finds the character and actor that caused damage from an effect context */
+	static void GetDamageSource(const FGameplayEffectContextHandle& Context, class ARPGCharacterBase*& OutSourceCharacter, AActor*& OutSourceActor);
+
+	/** Returns true if simulated proxies receive Health, Mana and MoveSpeed through QuantizedVitals */
+	static bool IsQuantizingProxyVitals();
+
 protected:
+	/** Quantized copy of the vitals, only replicated to simulated proxies */
+	UPROPERTY(ReplicatedUsing = OnRep_QuantizedVitals)
+	FRPGQuantizedVitals QuantizedVitals;
+
+	/** Marks a replicated attribute dirty for push model replication, and updates QuantizedVitals if needed */
+	void MarkAttributeDirty(const FGameplayAttribute& Attribute);
+
+	/** Applies a value received in QuantizedVitals to an attribute */
+	void ApplyQuantizedAttribute(FGameplayAttributeData& AttributeData, const FGameplayAttribute& Attribute, const FGameplayAttributeData& NewValue);
+
 	/** Helper function to proportionally adjust the value of an attribute when it's associated max attribute changes. (i.e. When MaxHealth increases, Health increases by an amount that maintains the same percentage as before) */
 	void AdjustAttributeForMaxChange(FGameplayAttributeData& AffectedAttribute, const FGameplayAttributeData& MaxAttribute, float NewMaxValue, const FGameplayAttribute& AffectedAttributeProperty);
 
@@ -92,4 +141,7 @@ protected:
 
 	UFUNCTION()
 	virtual void OnRep_MoveSpeed(const FGameplayAttributeData& OldValue);
+
+	UFUNCTION()
+	virtual void OnRep_QuantizedVitals();
 };
@@ -0,0 +1,126 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ActionRPG.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GenericTeamAgentInterface.h"
+#include "RPGCharacterSpatialHash.generated.h"
+
+class ARPGCharacterBase;
+
+/** Which teams a spatial query returns, relative to the team of the querying character */
+UENUM(BlueprintType)
+enum class ERPGTargetTeam : uint8
+{
+	/** Characters on a different team */
+	Hostile,
+	/** Characters on the same team */
+	Friendly,
+	/** Every character */
+	Any
+};
+
+/** Team filter of a spatial query */
+struct FRPGSpatialQueryFilter
+{
+	FRPGSpatialQueryFilter()
+		: TeamId(FGenericTeamId::NoTeam)
+		, Team(ERPGTargetTeam::Any)
+		, IgnoredCharacter(nullptr)
+	{}
+
+	/** Team the query is made for */
+	FGenericTeamId TeamId;
+
+	/** Teams to return, relative to TeamId */
+	ERPGTargetTeam Team;
+
+	/** Character to leave out, usually the one making the query */
+	const ARPGCharacterBase* IgnoredCharacter;
+};
+
+/**
+ * Uniform grid of the live characters in a world, with one grid per team, used for area targeting without physics queries
+ * Characters register themselves when they begin play. The grid is rebuilt from their locations on the first query of each frame, and characters with no health are left out
+ * Characters are tested as their capsule, like a physics overlap with the capsule would
+ */
+UCLASS()
+class ACTIONRPG_API URPGCharacterSpatialHash : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor
+	URPGCharacterSpatialHash();
+
+	/** Adds a character to the grid, called from BeginPlay */
+	void RegisterCharacter(ARPGCharacterBase* Character);
+
+	/** Removes a character from the grid, called from EndPlay */
+	void UnregisterCharacter(ARPGCharacterBase* Character);
+
+	/** Adds characters whose capsule overlaps the sphere */
+	void QuerySphere(const FVector& Center, float Radius, const FRPGSpatialQueryFilter& Filter, TArray<ARPGCharacterBase*>& OutCharacters);
+
+	/** Adds characters in range of Origin whose capsule is within HalfAngleDegrees of Direction, which must be normalized */
+	void QueryCone(const FVector& Origin, const FVector& Direction, float Range, float HalfAngleDegrees, const FRPGSpatialQueryFilter& Filter, TArray<ARPGCharacterBase*>& OutCharacters);
+
+	/** Adds characters whose capsule is touched by a sphere of SweepRadius moved from Start to End */
+	void QueryCapsuleSweep(const FVector& Start, const FVector& End, float SweepRadius, const FRPGSpatialQueryFilter& Filter, TArray<ARPGCharacterBase*>& OutCharacters);
+
+	/** Returns the number of registered characters */
+	int32 GetNumCharacters() const;
+
+protected:
+	/** Location and capsule of one character when the grid was built */
+	struct FEntry
+	{
+		ARPGCharacterBase* Character;
+		FVector Location;
+		float CapsuleRadius;
+		float CapsuleHalfHeight;
+		uint64 CellKey;
+
+		/** Returns the ends of the line the capsule is swept along */
+		void GetSegment(FVector& OutStart, FVector& OutEnd) const
+		{
+			const FVector Offset(0.0f, 0.0f, FMath::Max(CapsuleHalfHeight - CapsuleRadius, 0.0f));
+			OutStart = Location - Offset;
+			OutEnd = Location + Offset;
+		}
+	};
+
+	/** Entries of one team sorted by cell, each cell is a range of Entries */
+	struct FTeamGrid
+	{
+		FGenericTeamId TeamId;
+		TArray<FEntry> Entries;
+		TMap<uint64, TPair<int32, int32>> Cells;
+	};
+
+	/** Everything that has registered */
+	TArray<ARPGCharacterBase*> Characters;
+
+	/** Grids by team, there are only a few teams so this is searched linearly */
+	TArray<FTeamGrid> TeamGrids;
+
+	/** Frame the grids were built in */
+	uint64 BuiltFrame;
+
+	/** Size of the grid cells used by the current grids */
+	float BuiltCellSize;
+
+	/** Largest capsule radius in the grids, so queries don't miss capsules reaching into a cell */
+	float MaxCapsuleRadius;
+
+	/** Rebuilds the grids if they were built in an earlier frame */
+	void UpdateGrids();
+
+	/** Returns the key of the cell containing a location */
+	uint64 GetCellKey(const FVector& Location) const;
+	uint64 GetCellKey(int32 CellX, int32 CellY) const;
+
+	/** Calls Visitor for every entry in a team the filter accepts, in cells overlapping the bounds, extended by the largest capsule radius */
+	void ForEachCandidate(const FVector& BoundsMin, const FVector& BoundsMax, const FRPGSpatialQueryFilter& Filter, TFunctionRef<void(const FEntry&)> Visitor);
+};
@@ -0,0 +1,99 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ActionRPG.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameplayEffectTypes.h"
+#include "Engine/HitResult.h"
+#include "UObject/ObjectKey.h"
+#include "RPGDamageEventSubsystem.generated.h"
+
+class ARPGCharacterBase;
+
+/**
+ * Collects damage and health change callbacks from URPGAttributeSet during effect execution and dispatches them once per frame, after actors have ticked
+ * Damage events are dispatched in the order they happened, then each character gets a single health change with the sum of its changes this frame
+ */
+UCLASS()
+class ACTIONRPG_API URPGDamageEventSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Subsystem overrides
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Returns the subsystem to queue events for this character with, or null if its events should be handled immediately */
+	static URPGDamageEventSubsystem* GetForDeferredEvents(const ARPGCharacterBase* Character);
+
+	/** Queues an OnDamaged call, the source and hit result are read from the context when it is dispatched */
+	void QueueDamage(ARPGCharacterBase* Target, float DamageAmount, const FGameplayEffectContextHandle& EffectContext, const FGameplayTagContainer& DamageTags);
+
+	/** Adds to the health change of a character this frame, the tags of the last change are passed to OnHealthChanged */
+	void QueueHealthChange(ARPGCharacterBase* Target, float DeltaValue, const FGameplayTagContainer& EventTags);
+
+	/** Dispatches everything that is queued, events queued by the callbacks are dispatched as well */
+	void FlushEvents();
+
+	/** Passed to HandleDamage for events without a hit, so callers bind a reference instead of copying a hit result */
+	static const FHitResult EmptyHitResult;
+
+protected:
+	/** A queued OnDamaged call */
+	struct FDamageEvent
+	{
+		TWeakObjectPtr<ARPGCharacterBase> Target;
+		FGameplayEffectContextHandle EffectContext;
+		float DamageAmount;
+		int32 TagsIndex;
+	};
+
+	/** Summed health changes of one character */
+	struct FHealthChange
+	{
+		TWeakObjectPtr<ARPGCharacterBase> Target;
+		float DeltaValue;
+		int32 TagsIndex;
+	};
+
+	/** Everything queued since the last dispatch */
+	struct FEventQueue
+	{
+		TArray<FDamageEvent> DamageEvents;
+		TArray<FHealthChange> HealthChanges;
+		TMap<TObjectKey<ARPGCharacterBase>, int32> HealthChangeIndices;
+
+		/** Tags referenced by events, consecutive events with the same tags share an entry */
+		TArray<FGameplayTagContainer> EventTags;
+
+		bool IsEmpty() const
+		{
+			return DamageEvents.Num() == 0 && HealthChanges.Num() == 0;
+		}
+
+		void Reset()
+		{
+			DamageEvents.Reset();
+			HealthChanges.Reset();
+			HealthChangeIndices.Reset();
+			EventTags.Reset();
+		}
+	};
+
+	/** Events waiting for the end of the frame */
+	FEventQueue PendingEvents;
+
+	/** Queue being dispatched, kept so its allocations are reused */
+	FEventQueue DispatchingEvents;
+
+	/** Handle for the post actor tick callback */
+	FDelegateHandle PostActorTickHandle;
+
+	/** Returns the index of the tags in the pending queue */
+	int32 AddEventTags(const FGameplayTagContainer& Tags);
+
+	/** Called by the world after all actors have ticked */
+	void HandlePostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+};
@@ -6,6 +6,45 @@
 #include "GameplayEffectExecutionCalculation.h"
 #include "RPGDamageExecution.generated.h"
 
+class UAbilitySystemComponent;
+class UGameplayEffect;
+
+/**
+ * While one of these is alive, damage executions of its spec evaluate the source AttackPower and Damage once and reuse them for the other targets
+ * The engine runs the execution once per target, on a copy of the spec with a duplicated context, so it is opened where all the targets of one application are known
+ * Specs whose damage executions have scoped modifiers that read the target, use a custom calculation or require tags are never cached
+ */
+struct ACTIONRPG_API FRPGDamageSourceScope
+{
+public:
+	explicit FRPGDamageSourceScope(const FGameplayEffectSpec& Spec);
+	~FRPGDamageSourceScope();
+
+	/** Returns the innermost open scope for a copy of this spec from this source, or null */
+	static FRPGDamageSourceScope* Find(const FGameplayEffectSpec& Spec, const UAbilitySystemComponent* SourceComponent);
+
+	/** Returns true and the cached magnitudes if they were evaluated with the same tags */
+	bool GetMagnitudes(const FGameplayTagContainer* SourceTags, const FGameplayTagContainer* TargetTags, float& OutAttackPower, float& OutDamage) const;
+
+	/** Caches the magnitudes evaluated for one target */
+	void SetMagnitudes(const FGameplayTagContainer* SourceTags, const FGameplayTagContainer* TargetTags, float AttackPower, float Damage);
+
+private:
+	FRPGDamageSourceScope* OuterScope;
+	const UGameplayEffect* EffectDef;
+	const UAbilitySystemComponent* SourceComponent;
+	float Level;
+	bool bCanCache;
+	bool bHasMagnitudes;
+
+	/** Source modifiers can require target tags, so targets with different tags evaluate again */
+	FGameplayTagContainer SourceTags;
+	FGameplayTagContainer TargetTags;
+
+	float AttackPower;
+	float Damage;
+};
+
 /**
  * A damage execution, which allows doing damage by combining a raw Damage number with AttackPower and DefensePower
  * Most games will want to implement multiple game-specific executions
@@ -5,6 +5,7 @@
 #include "ActionRPG.h"
 #include "Abilities/GameplayAbilityTypes.h"
 #include "Abilities/RPGAbilityTypes.h"
+#include "Abilities/RPGCharacterSpatialHash.h"
 #include "RPGTargetType.generated.h"
 
 class ARPGCharacterBase;
@@ -59,3 +60,99 @@ public:
 	/** Uses the passed in event data */
 	virtual void GetTargets_Implementation(ARPGCharacterBase* TargetingCharacter, AActor* TargetingActor, FGameplayEventData EventData, TArray<FHitResult>& OutHitResults, TArray<AActor*>& OutActors) const override;
 };
+
+/**
+ * Base for target types that find characters in an area through URPGCharacterSpatialHash instead of physics queries
+ * The area is placed relative to the targeting actor, or the targeting character if there is no actor
+ * Abilities use the class default object, so content subclasses one of the shapes in blueprint to set the size and filter
+ */
+UCLASS(Abstract, NotBlueprintable)
+class ACTIONRPG_API URPGTargetType_Area : public URPGTargetType
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor and overrides
+	URPGTargetType_Area();
+
+	/** Offset of the area from the targeting actor, in the space of the actor */
+	UPROPERTY(EditDefaultsOnly, Category = Targeting)
+	FVector OriginOffset;
+
+	/** Teams to target, relative to the team of the targeting character */
+	UPROPERTY(EditDefaultsOnly, Category = Targeting)
+	ERPGTargetTeam TeamFilter;
+
+	/** If true the targeting character can target itself */
+	UPROPERTY(EditDefaultsOnly, Category = Targeting)
+	bool bIncludeSelf;
+
+	/** Adds the characters in the area to OutActors */
+	virtual void GetTargets_Implementation(ARPGCharacterBase* TargetingCharacter, AActor* TargetingActor, FGameplayEventData EventData, TArray<FHitResult>& OutHitResults, TArray<AActor*>& OutActors) const override;
+
+protected:
+	/** Runs the query for this shape, Origin already includes the offset and Forward is normalized */
+	virtual void QueryCharacters(URPGCharacterSpatialHash* SpatialHash, const FVector& Origin, const FVector& Forward, const FRPGSpatialQueryFilter& Filter, TArray<ARPGCharacterBase*>& OutCharacters) const {}
+};
+
+/** Targets characters whose capsule overlaps a sphere */
+UCLASS(Blueprintable)
+class ACTIONRPG_API URPGTargetType_Sphere : public URPGTargetType_Area
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor and overrides
+	URPGTargetType_Sphere();
+
+	/** Radius of the sphere */
+	UPROPERTY(EditDefaultsOnly, Category = Targeting)
+	float Radius;
+
+protected:
+	virtual void QueryCharacters(URPGCharacterSpatialHash* SpatialHash, const FVector& Origin, const FVector& Forward, const FRPGSpatialQueryFilter& Filter, TArray<ARPGCharacterBase*>& OutCharacters) const override;
+};
+
+/** Targets characters in front of the targeting actor, within an angle of its forward direction */
+UCLASS(Blueprintable)
+class ACTIONRPG_API URPGTargetType_Cone : public URPGTargetType_Area
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor and overrides
+	URPGTargetType_Cone();
+
+	/** Length of the cone */
+	UPROPERTY(EditDefaultsOnly, Category = Targeting)
+	float Range;
+
+	/** Angle between the forward direction and the edge of the cone */
+	UPROPERTY(EditDefaultsOnly, Category = Targeting, meta = (ClampMin = "0", ClampMax = "180"))
+	float HalfAngleDegrees;
+
+protected:
+	virtual void QueryCharacters(URPGCharacterSpatialHash* SpatialHash, const FVector& Origin, const FVector& Forward, const FRPGSpatialQueryFilter& Filter, TArray<ARPGCharacterBase*>& OutCharacters) const override;
+};
+
+/** Targets characters touched by a sphere swept forward from the targeting actor, like a charge or a piercing shot */
+UCLASS(Blueprintable)
+class ACTIONRPG_API URPGTargetType_CapsuleSweep : public URPGTargetType_Area
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor and overrides
+	URPGTargetType_CapsuleSweep();
+
+	/** How far forward the sphere is swept */
+	UPROPERTY(EditDefaultsOnly, Category = Targeting)
+	float Distance;
+
+	/** Radius of the swept sphere */
+	UPROPERTY(EditDefaultsOnly, Category = Targeting)
+	float SweepRadius;
+
+protected:
+	virtual void QueryCharacters(URPGCharacterSpatialHash* SpatialHash, const FVector& Origin, const FVector& Forward, const FRPGSpatialQueryFilter& Filter, TArray<ARPGCharacterBase*>& OutCharacters) const override;
+};
@@ -5,6 +5,7 @@
 #include "ActionRPG.h"
 #include "Engine/DataAsset.h"
 #include "Styling/SlateBrush.h"
+#include "UObject/ObjectSaveContext.h"
 #include "RPGAssetManager.h"
 #include "RPGItem.generated.h"
 
@@ -23,6 +24,7 @@ public:
 		, MaxCount(1)
 		, MaxLevel(1)
 		, AbilityLevel(1)
+		, ItemRegistryIndex(INDEX_NONE)
 	{}
 
 	/** Type of this item, set in native parent class */
@@ -37,10 +39,14 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Item)
 	FText ItemDescription;
 
-	/** Icon to display */
+	/** Icon to display. If bStreamItemIcons is set on the asset manager the texture is only in SoftItemIcon, use RequestItemIcon to get a brush with it filled in */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Item)
 	FSlateBrush ItemIcon;
 
+	/** Texture or material for the icon, loaded on demand by the icon cache. Filled in from ItemIcon when an older item is loaded in the editor */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Item, meta = (AllowedClasses = "/Script/Engine.Texture,/Script/Engine.MaterialInterface"))
+	TSoftObjectPtr<UObject> SoftItemIcon;
+
 	/** Price in game */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Item)
 	int32 Price;
@@ -69,8 +75,28 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Item)
 	FString GetIdentifierString() const;
 
+	/** Returns the registry id of this item, registering it if needed. Inventories store the id when the item is added, so hot paths do not need this */
+	int32 GetRegistryIndex();
+
 	/** Overridden to use saved type */
 	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+#if WITH_EDITOR
+	/** Keeps the registry stats in sync with edits */
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+
+	/** Moves the icon texture to SoftItemIcon */
+	virtual void PostLoad() override;
+
+	/** Drops the hard icon reference when icons are streamed */
+	virtual void PreSave(FObjectPreSaveContext ObjectSaveContext) override;
+#endif
+
+private:
+	/** Id of this item in the asset manager's item registry, INDEX_NONE until registered. Only the asset manager assigns it */
+	int32 ItemRegistryIndex;
+
+	friend class URPGAssetManager;
 };
 
 
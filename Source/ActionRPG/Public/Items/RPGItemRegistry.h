@@ -0,0 +1,82 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ActionRPG.h"
+
+class URPGItem;
+class URPGGameplayAbility;
+
+/**
+ * Dense table of the item stats read on hot paths, stored as one array per stat
+ * Every item gets a small integer id when the asset manager scans items, the stats are filled in once the item is loaded
+ * This does not reference the item objects, the item cache in the asset manager keeps registered items loaded
+ */
+class ACTIONRPG_API FRPGItemRegistry
+{
+public:
+	/** Removes every item */
+	void Reset();
+
+	/** Returns the id of an item, assigning a new one if it does not have one yet */
+	int32 AddItem(const FPrimaryAssetId& ItemId);
+
+	/** Returns the id of an item, or INDEX_NONE */
+	int32 FindIndex(const FPrimaryAssetId& ItemId) const
+	{
+		const int32* FoundIndex = IndexById.Find(ItemId);
+		return FoundIndex ? *FoundIndex : INDEX_NONE;
+	}
+
+	/** Copies the stats of a loaded item into its id */
+	void SetItemStats(int32 Index, const URPGItem* Item);
+
+	/** Number of ids assigned */
+	int32 Num() const
+	{
+		return AssetIds.Num();
+	}
+
+	/** Returns true if the id is valid */
+	bool IsValidIndex(int32 Index) const
+	{
+		return AssetIds.IsValidIndex(Index);
+	}
+
+	/** Returns true if the stats for this id have been filled in */
+	bool HasStats(int32 Index) const
+	{
+		return IsValidIndex(Index) && StatsSet[Index];
+	}
+
+	// Stat accessors, the id must have stats
+	const FPrimaryAssetId& GetAssetId(int32 Index) const { return AssetIds[Index]; }
+	const FPrimaryAssetType& GetItemType(int32 Index) const { return ItemTypes[Index]; }
+	ERPGItemType GetNativeItemType(int32 Index) const { return NativeItemTypes[Index]; }
+	int32 GetMaxCount(int32 Index) const { return MaxCounts[Index]; }
+	int32 GetMaxLevel(int32 Index) const { return MaxLevels[Index]; }
+	int32 GetAbilityLevel(int32 Index) const { return AbilityLevels[Index]; }
+	TSubclassOf<URPGGameplayAbility> GetGrantedAbility(int32 Index) const { return GrantedAbilities[Index]; }
+
+	// Whole columns, for code that walks many items
+	TArrayView<const int32> GetMaxCounts() const { return MaxCounts; }
+	TArrayView<const int32> GetMaxLevels() const { return MaxLevels; }
+	TArrayView<const int32> GetAbilityLevels() const { return AbilityLevels; }
+	TArrayView<const ERPGItemType> GetNativeItemTypes() const { return NativeItemTypes; }
+
+private:
+	/** Id for each asset */
+	TMap<FPrimaryAssetId, int32> IndexById;
+
+	/** Stat columns, indexed by id */
+	TArray<FPrimaryAssetId> AssetIds;
+	TArray<FPrimaryAssetType> ItemTypes;
+	TArray<ERPGItemType> NativeItemTypes;
+	TArray<int32> MaxCounts;
+	TArray<int32> MaxLevels;
+	TArray<int32> AbilityLevels;
+	TArray<TSubclassOf<URPGGameplayAbility>> GrantedAbilities;
+
+	/** Set for ids whose item has been loaded */
+	TBitArray<> StatsSet;
+};
@@ -4,23 +4,29 @@
 
 #include "ActionRPG.h"
 #include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Items/RPGItemRegistry.h"
+#include "Styling/SlateBrush.h"
 #include "RPGAssetManager.generated.h"
 
 class URPGItem;
 
+/** Delegate called when an item icon requested with RequestItemIcon is ready */
+DECLARE_DYNAMIC_DELEGATE_TwoParams(FOnItemIconLoaded, URPGItem*, Item, const FSlateBrush&, Icon);
+
 /**
  * Game implementation of asset manager, overrides functionality and stores game-specific types
  * It is expected that most games will want to override AssetManager as it provides a good place for game-specific loading logic
  * This is used by setting AssetManagerClassName in DefaultEngine.ini
  */
-UCLASS()
+UCLASS(config = Game)
 class ACTIONRPG_API URPGAssetManager : public UAssetManager
 {
 	GENERATED_BODY()
 
 public:
 	// Constructor and overrides
-	URPGAssetManager() {}
+	URPGAssetManager();
 	virtual void StartInitialLoading() override;
 
 	/** Static types for items */
@@ -33,12 +39,157 @@ public:
 	static URPGAssetManager& Get();
 
 	/**
-	 * Synchronously loads an RPGItem subclass, this can hitch but is useful when you cannot wait for an async load
-	 * This does not maintain a reference to the item so it will garbage collect if not loaded some other way
+	 * Returns an RPGItem subclass from the item cache, synchronously loading it on a miss. A miss can hitch but is useful when you cannot wait for an async load
+	 * Loaded items are kept in the cache, so they stay loaded for the lifetime of the asset manager
 	 *
 	 * @param PrimaryAssetId The asset identifier to load
 	 * @param bDisplayWarning If true, this will log a warning if the item failed to load
 	 */
 	URPGItem* ForceLoadItem(const FPrimaryAssetId& PrimaryAssetId, bool bLogWarning = true);
+
+	/**
+	 * Item types that are loaded with PreloadBundles once the initial asset scan is done, so they load behind the startup movie with progress on the loading screen
+	 * Empty unless set in config, only used by game clients. The item cache is warmed with every item type regardless, see WarmItemCache
+	 */
+	UPROPERTY(config)
+	TArray<FName> PreloadItemTypes;
+
+	/** Asset bundles to load along with the preloaded items */
+	UPROPERTY(config)
+	TArray<FName> PreloadBundles;
+
+	/** Starts an async load of every Potion, Skill, Token and Weapon item into the item cache, without bundles */
+	void WarmItemCache();
+
+	/** Starts an async load of every item of the PreloadItemTypes, reporting progress to the loading screen */
+	void PreloadItems();
+
+	/** Returns true while item types are still being preloaded */
+	bool IsPreloadingItems() const;
+
+	/** Returns preload progress from 0 to 1 */
+	float GetItemPreloadProgress() const;
+
+	/** Returns the seconds each preloaded type took to load, types that have not finished are left out */
+	void GetItemPreloadTimes(TMap<FPrimaryAssetType, float>& OutLoadTimes) const;
+
+	/** Number of ForceLoadItem calls served from the item cache */
+	int32 GetItemCacheHits() const { return ItemCacheHits; }
+
+	/** Number of ForceLoadItem calls that had to load the item */
+	int32 GetItemCacheMisses() const { return ItemCacheMisses; }
+
+	/** Total seconds spent in synchronous loads on cache misses */
+	double GetItemLoadSeconds() const { return ItemLoadSeconds; }
+
+	/** Number of items in the cache */
+	int32 GetNumCachedItems() const { return ItemCache.Num(); }
+
+	/** Returns the dense stat table for items */
+	const FRPGItemRegistry& GetItemRegistry() const { return ItemRegistry; }
+
+	/** Makes sure a loaded item has a registry id with its stats filled in, and returns the id */
+	int32 RegisterItem(URPGItem* Item);
+
+	/** If true, saving an item in the editor clears the texture from ItemIcon so only SoftItemIcon references it. Widgets must then use RequestItemIcon */
+	UPROPERTY(config)
+	bool bStreamItemIcons;
+
+	/** Memory budget for streamed item icons in KB, the least recently requested icons are released once it is exceeded */
+	UPROPERTY(config)
+	int32 ItemIconBudgetKB;
+
+	/** Calls Delegate with the icon brush of an item, right away if the icon is loaded or once it has streamed in */
+	void RequestItemIcon(URPGItem* Item, const FOnItemIconLoaded& Delegate);
+
+	/** Icon cache counters */
+	int32 GetItemIconHits() const { return ItemIconHits; }
+	int32 GetItemIconMisses() const { return ItemIconMisses; }
+	int32 GetItemIconEvictions() const { return ItemIconEvictions; }
+	int64 GetItemIconResidentBytes() const { return ItemIconResidentBytes; }
+
+protected:
+	/** Assigns registry ids to every item found by the scan */
+	virtual void PostInitialAssetScan() override;
+
+	/** Adds an item to the cache and registers its stats */
+	void CacheItem(const FPrimaryAssetId& ItemId, URPGItem* Item);
+
+	/** Dense stats for every scanned or loaded item */
+	FRPGItemRegistry ItemRegistry;
+
+	/** Loaded items, this holds a reference so they are not garbage collected */
+	UPROPERTY()
+	TMap<FPrimaryAssetId, URPGItem*> ItemCache;
+
+	/** Cache counters */
+	int32 ItemCacheHits;
+	int32 ItemCacheMisses;
+	double ItemLoadSeconds;
+
+	/** Real time WarmItemCache started, for the log */
+	double ItemCacheWarmStartTime;
+
+	/** Called when the items loaded by WarmItemCache are in memory */
+	void HandleItemCacheWarmed(TArray<FPrimaryAssetId> ItemIds);
+
+	/** State of the preload of one item type */
+	struct FItemTypePreload
+	{
+		FPrimaryAssetType ItemType;
+		TSharedPtr<FStreamableHandle> Handle;
+		double StartTime;
+		float LoadSeconds;
+		bool bComplete;
+	};
+
+	/** One entry per preloaded type, the handles keep the items loaded */
+	TArray<FItemTypePreload> ItemTypePreloads;
+
+	/** A request waiting for an icon to stream in */
+	struct FItemIconRequest
+	{
+		TWeakObjectPtr<URPGItem> Item;
+		FOnItemIconLoaded Delegate;
+	};
+
+	/** A streamed icon, it stays loaded while the handle is held */
+	struct FItemIconEntry
+	{
+		TSharedPtr<FStreamableHandle> Handle;
+		TArray<FItemIconRequest> Requests;
+		int64 SizeBytes = 0;
+		uint64 LastUse = 0;
+	};
+
+	/** Streamed icons by texture path */
+	TMap<FSoftObjectPath, FItemIconEntry> ItemIcons;
+
+	/** Incremented by every request, used to find the least recently used icon */
+	uint64 ItemIconUseCounter;
+
+	/** Icon cache counters */
+	int32 ItemIconHits;
+	int32 ItemIconMisses;
+	int32 ItemIconEvictions;
+	int64 ItemIconResidentBytes;
+
+	/** Called when an icon has streamed in */
+	void HandleItemIconLoaded(FSoftObjectPath IconPath);
+
+	/** Releases least recently used icons until the cache is inside the budget */
+	void TrimItemIcons(const FSoftObjectPath& KeepPath);
+
+	/** Returns the ItemIcon brush of an item using a streamed texture */
+	static FSlateBrush MakeItemIconBrush(const URPGItem* Item, UObject* IconObject);
+
+	/** Called when all items of a preloaded type are loaded, adds them to the cache */
+	void HandleItemTypePreloaded(FPrimaryAssetType ItemType);
+
+	/** Called as preload handles make progress */
+	void HandleItemPreloadUpdate(TSharedRef<FStreamableHandle> Handle);
+
+	/** Passes the current preload progress to the loading screen */
+	void UpdateLoadingScreenProgress() const;
 };
 
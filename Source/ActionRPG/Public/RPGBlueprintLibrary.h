@@ -4,6 +4,7 @@
 
 #include "ActionRPG.h"
 #include "RPGTypes.h"
+#include "RPGAssetManager.h"
 #include "Abilities/RPGAbilityTypes.h"
 #include "RPGBlueprintLibrary.generated.h"
 
@@ -41,6 +42,10 @@ public:
 	UFUNCTION(BlueprintPure, Category = Inventory)
 	static bool IsValidItemSlot(const FRPGItemSlot& ItemSlot);
 
+	/** Streams in the icon of an item and calls OnLoaded with a brush for it, right away if it is already loaded */
+	UFUNCTION(BlueprintCallable, Category = Inventory)
+	static void RequestItemIcon(URPGItem* Item, FOnItemIconLoaded OnLoaded);
+
 	/** Checks if spec has any effects */
 	UFUNCTION(BlueprintPure, Category = Ability)
 	static bool DoesEffectContainerSpecHaveEffects(const FRPGGameplayEffectContainerSpec& ContainerSpec);
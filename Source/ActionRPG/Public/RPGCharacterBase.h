@@ -14,6 +14,7 @@
 
 class URPGGameplayAbility;
 class UGameplayEffect;
+class URPGDamageEventSubsystem;
 
 /** Base class for Character, Designed to be blueprinted */
 UCLASS()
@@ -24,6 +25,8 @@ class ACTIONRPG_API ARPGCharacterBase : public ACharacter, public IAbilitySystem
 public:
 	// Constructor and overrides
 	ARPGCharacterBase();
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void PossessedBy(AController* NewController) override;
 	virtual void UnPossessed() override;
 	virtual void OnRep_Controller() override;
@@ -72,6 +75,9 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Abilities")
 	void GetActiveAbilitiesWithItemSlot(FRPGItemSlot ItemSlot, TArray<URPGGameplayAbility*>& ActiveAbilities);
 
+	/** Native version of GetActiveAbilitiesWithItemSlot that calls Visitor for each ability instead of filling an array */
+	void ForEachActiveAbilityWithItemSlot(FRPGItemSlot ItemSlot, TFunctionRef<void(URPGGameplayAbility*)> Visitor);
+
 	/**
 	 * Attempts to activate all abilities that match the specified tags
 	 * Returns true if it thinks it activated, but it may return false positives due to failure later in activation.
@@ -86,7 +92,13 @@ public:
 
 	/** Returns total time and remaining time for cooldown tags. Returns false if no active cooldowns found */
 	UFUNCTION(BlueprintCallable, Category = "Abilities")
-	bool GetCooldownRemainingForTag(FGameplayTagContainer CooldownTags, float& TimeRemaining, float& CooldownDuration);
+	bool GetCooldownRemainingForTag(const FGameplayTagContainer& CooldownTags, float& TimeRemaining, float& CooldownDuration);
+
+	/**
+	 * Builds the spec for the ability a slotted item grants, returns false if it grants none
+	 * ItemIndex is the registry index stored with the item by the inventory, if it is INDEX_NONE it is read from the item
+	 */
+	bool MakeItemAbilitySpec(URPGItem* SlottedItem, int32 ItemIndex, FGameplayAbilitySpec& OutSpec);
 
 protected:
 	/** The level of this character, should not be modified directly once it has already spawned */
@@ -105,6 +117,14 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Abilities)
 	TArray<TSubclassOf<UGameplayEffect>> PassiveGameplayEffects;
 
+	/** If true, OnDamaged and OnHealthChanged are called as soon as damage is applied. If false they are batched at the end of the frame by URPGDamageEventSubsystem */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Abilities)
+	bool bHandleDamageImmediately;
+
+	/** If true, a level change updates the level of granted abilities and passive effects in place. If false, everything is removed and granted again */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Abilities)
+	bool bUpdateAbilitiesInPlaceOnLevelChange;
+
 	/** The component used to handle ability system interactions */
 	UPROPERTY()
 	URPGAbilitySystemComponent* AbilitySystemComponent;
@@ -125,6 +145,9 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Inventory)
 	TMap<FRPGItemSlot, FGameplayAbilitySpecHandle> SlottedAbilities;
 
+	/** Handles of the applied PassiveGameplayEffects */
+	TArray<FActiveGameplayEffectHandle> PassiveEffectHandles;
+
 	/** Delegate handles */
 	FDelegateHandle InventoryUpdateHandle;
 	FDelegateHandle InventoryLoadedHandle;
@@ -173,18 +196,27 @@ protected:
 	void OnItemSlotChanged(FRPGItemSlot ItemSlot, URPGItem* Item);
 	void RefreshSlottedGameplayAbilities();
 
+	/** Regrants the ability of a single slot if it changed, this clears and gives at most one ability */
+	void RefreshSlottedGameplayAbility(const FRPGItemSlot& ItemSlot, URPGItem* Item);
+
 	/** Apply the startup gameplay abilities and effects */
 	void AddStartupGameplayAbilities();
 
 	/** Attempts to remove any startup gameplay abilities */
 	void RemoveStartupGameplayAbilities();
 
+	/** Moves granted abilities and passive effects to the current character level without removing them */
+	void UpdateAbilityLevels(int32 OldLevel);
+
 	/** Adds slotted item abilities if needed */
 	void AddSlottedGameplayAbilities();
 
 	/** Fills in with ability specs, based on defaults and inventory */
 	void FillSlottedAbilitySpecs(TMap<FRPGItemSlot, FGameplayAbilitySpec>& SlottedAbilitySpecs);
 
+	/** Returns the registry index the inventory stored for the item in a slot, or INDEX_NONE if the slot holds a different item */
+	int32 GetSlottedItemRegistryIndex(const FRPGItemSlot& ItemSlot, const URPGItem* SlottedItem) const;
+
 	/** Remove slotted gameplay abilities, if force is false it only removes invalid ones */
 	void RemoveSlottedGameplayAbilities(bool bRemoveAll);
 
@@ -199,4 +231,5 @@ protected:
 
 	// Friended to allow access to handle functions above
 	friend URPGAttributeSet;
+	friend URPGDamageEventSubsystem;
 };
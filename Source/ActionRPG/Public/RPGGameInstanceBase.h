@@ -4,10 +4,22 @@
 
 #include "ActionRPG.h"
 #include "Engine/GameInstance.h"
+#include "Containers/Ticker.h"
+#include "RPGSaveGame.h"
+#include "RPGSaveJournal.h"
 #include "RPGGameInstanceBase.generated.h"
 
 class URPGItem;
-class URPGSaveGame;
+
+/** How inventory changes are persisted between full save game writes */
+UENUM(BlueprintType)
+enum class ERPGSavePersistenceMode : uint8
+{
+	/** Every change writes a full snapshot of the save game, using the save scheduler */
+	Snapshot,
+	/** Every change is appended to a small journal file right away, full snapshots are only written to compact the journal */
+	Journaled
+};
 
 /**
  * Base class for GameInstance, should be blueprinted
@@ -20,8 +32,10 @@ class ACTIONRPG_API URPGGameInstanceBase : public UGameInstance
 	GENERATED_BODY()
 
 public:
-	// Constructor
+	// Constructor and overrides
 	URPGGameInstanceBase();
+	virtual void Init() override;
+	virtual void Shutdown() override;
 
 	/** List of inventory items to add to new players */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Inventory)
@@ -39,6 +53,47 @@ public:
 	UPROPERTY(BlueprintReadWrite, Category = Save)
 	int32 SaveUserIndex;
 
+	/**
+	 * If true, Init starts an async load of the save game so the read overlaps with startup and map loading behind the loading screen
+	 * BP_GameInstance also loads the slot from its Init graph and calls HandleSaveGameLoaded. One result for the same slot and user that arrives while the preload
+	 * is in flight, or after it with nothing saved since, is dropped so the save, OnSaveGameLoaded and the inventory load only happen once
+	 * The blueprint load can be removed once this is enabled
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Save)
+	bool bPreloadSaveGame;
+
+	/** Format used to store the inventory in new and loaded save games, older saves are converted the next time they are written */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Save)
+	ERPGSaveInventoryFormat SaveInventoryFormat;
+
+	/** How inventory changes are written. Journaled mode writes next to the save game in the Saved directory, so it needs a platform with regular file access */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Save)
+	ERPGSavePersistenceMode PersistenceMode;
+
+	/** In journaled mode, a snapshot is written to compact the journal once it holds this many records */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Save)
+	int32 JournalCompactionThreshold;
+
+	/** Minimum time in seconds between two writes to disk. Save requests inside this window are merged into a single write */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Save)
+	float MinSaveInterval;
+
+	/** Maximum time in seconds a requested save can wait before it is written. If this is shorter than MinSaveInterval it wins */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Save)
+	float MaxSaveLatency;
+
+	/** Number of times WriteSaveGame was called while saving was enabled */
+	UPROPERTY(BlueprintReadOnly, Category = Save)
+	int32 SaveRequestCount;
+
+	/** Number of save requests that were merged into a write that was already waiting */
+	UPROPERTY(BlueprintReadOnly, Category = Save)
+	int32 SaveCoalescedCount;
+
+	/** Number of writes to disk that were actually started */
+	UPROPERTY(BlueprintReadOnly, Category = Save)
+	int32 SaveWriteCount;
+
 	/** Delegate called when the save game has been loaded/reset */
 	UPROPERTY(BlueprintAssignable, Category = Inventory)
 	FOnSaveGameLoaded OnSaveGameLoaded;
@@ -70,7 +125,18 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Save)
 	bool LoadOrCreateSaveGame();
 
-	/** Handle the final setup required after loading a USaveGame object using AsyncLoadGameFromSlot. Returns true if it loaded, false if it created one */
+	/** Starts loading the save game on a background thread. OnSaveGameLoaded is called once it is ready, with a new save game if none existed */
+	UFUNCTION(BlueprintCallable, Category = Save)
+	void LoadOrCreateSaveGameAsync();
+
+	/** Returns true if an async save game load is in flight */
+	UFUNCTION(BlueprintPure, Category = Save)
+	bool IsSaveGameLoading() const;
+
+	/**
+	 * Handle the final setup required after loading a USaveGame object using AsyncLoadGameFromSlot. Returns true if it loaded, false if it created one
+	 * This replaces any native load still in flight. A call that only repeats the preload started by Init is ignored, see bPreloadSaveGame
+	 */
 	UFUNCTION(BlueprintCallable, Category = Save)
 	bool HandleSaveGameLoaded(USaveGame* SaveGameObject);
 
@@ -78,11 +144,25 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Save)
 	void GetSaveSlotInfo(FString& SlotName, int32& UserIndex) const;
 
-	/** Writes the current save game object to disk. The save to disk happens in a background thread*/
+	/** Requests the current save game object be written to disk. The write is scheduled based on MinSaveInterval/MaxSaveLatency and happens in a background thread */
 	UFUNCTION(BlueprintCallable, Category = Save)
 	bool WriteSaveGame();
 
-	/** Resets the current save game to it's default. This will erase player data! This won't save to disk until the next WriteSaveGame */
+	/** Starts any write that is waiting on the scheduler right away. This is done automatically on map travel and shutdown */
+	UFUNCTION(BlueprintCallable, Category = Save)
+	void FlushSaveGame();
+
+	/** Returns true if inventory changes are being appended to the save journal */
+	UFUNCTION(BlueprintPure, Category = Save)
+	bool IsJournalingSaves() const;
+
+	/** Appends an inventory entry change to the save journal, pass null ItemData for a removed item. Does nothing unless journaling */
+	void JournalInventoryItem(const FPrimaryAssetId& ItemId, const FRPGItemData* ItemData);
+
+	/** Appends a slot change to the save journal, pass an invalid ItemId for an emptied slot. Does nothing unless journaling */
+	void JournalSlottedItem(const FRPGItemSlot& ItemSlot, const FPrimaryAssetId& ItemId);
+
+	/** Resets the current save game to it's default. This will erase player data! Any waiting write is flushed synchronously first, the reset won't save to disk until the next WriteSaveGame */
 	UFUNCTION(BlueprintCallable, Category = Save)
 	void ResetSaveGame();
 
@@ -99,9 +179,85 @@ protected:
 	UPROPERTY()
 	bool bCurrentlySaving;
 
-	/** True if another save was requested during a save */
+	/** True if a save was requested that has not been handed to a write yet */
+	UPROPERTY()
+	bool bSaveGameDirty;
+
+	/** True if the waiting save should start as soon as the current write finishes */
 	UPROPERTY()
-	bool bPendingSaveRequested;
+	bool bFlushRequested;
+
+	/** True once Shutdown has run, a background write that finishes later is ignored */
+	UPROPERTY()
+	bool bHasShutDown;
+
+	/** True while an async load started by LoadOrCreateSaveGameAsync is in flight */
+	UPROPERTY()
+	bool bSaveGameLoadPending;
+
+	/** Incremented by every load, so an async load that was superseded is ignored */
+	int32 SaveGameLoadSerial;
+
+	/** Load serial of the preload started by Init, 0 once the blueprint load it replaces has been dropped or if there was no preload */
+	int32 PreloadSaveGameSerial;
+
+	/** Slot and user the preload read */
+	FString PreloadSaveSlot;
+	int32 PreloadSaveUserIndex;
+
+	/** SaveRequestCount when the preload was applied, a later save means the slot on disk no longer matches it */
+	int32 PreloadSaveRequestCount;
+
+	/** Returns true if a blueprint load result would only repeat the preload started by Init */
+	bool ShouldSkipBlueprintSaveGameLoad() const;
+
+	/** Replaces the current save game with a loaded one, or a new one if null, and broadcasts OnSaveGameLoaded. Returns true if it loaded */
+	bool ApplySaveGame(USaveGame* SaveGameObject);
+
+	/** Journal for the current save slot, only written in journaled mode */
+	FRPGSaveJournal SaveJournal;
+
+	/** Journal records appended since the last WriteSaveGame, if there are none the change being saved was not journaled */
+	int32 JournalRecordsSinceWrite;
+
+	/** Journal sequence included in the snapshot currently being written */
+	int64 SavingJournalSequence;
+
+	/** Real time of the first request that is still waiting to be written */
+	double FirstDirtyTime;
+
+	/** Real time the last write was started */
+	double LastWriteTime;
+
+	/** Ticker used to start a delayed write, this keeps running while the game is paused */
+	FTSTicker::FDelegateHandle SaveTickerHandle;
+
+	/** Handle for the map load callback */
+	FDelegateHandle PreLoadMapHandle;
+
+	/** Starts the waiting write now if allowed, or sets up the ticker to start it later */
+	void ScheduleSave();
+
+	/** Starts an async write of the current save game */
+	void StartAsyncSave();
+
+	/** Waits for a background write that is still running, then writes the save game on this thread. Used when there is no time left to wait for a scheduled write */
+	void FlushSaveGameSynchronous();
+
+	/** Called by the ticker when a delayed write is due */
+	bool HandleSaveTicker(float DeltaTime);
+
+	/** Stamps the current save game with the journal sequence it will contain */
+	void PrepareSnapshot();
+
+	/** Called once a snapshot is on disk, drops the journal records it contains */
+	void HandleSnapshotWritten(bool bSuccess);
+
+	/** Called before a map load, so nothing waits across travel */
+	void HandlePreLoadMap(const FString& MapName);
+
+	/** Called when the async load started by LoadOrCreateSaveGameAsync finishes */
+	void HandleAsyncLoad(const FString& SlotName, const int32 UserIndex, USaveGame* LoadedSave, int32 LoadSerial);
 
 	/** Called when the async save happens */
 	virtual void HandleAsyncSave(const FString& SlotName, const int32 UserIndex, bool bSuccess);
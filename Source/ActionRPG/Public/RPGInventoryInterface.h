@@ -24,8 +24,8 @@ public:
 	/** Returns the map of items to data */
 	virtual const TMap<URPGItem*, FRPGItemData>& GetInventoryDataMap() const = 0;
 
-	/** Returns the map of slots to items */
-	virtual const TMap<FRPGItemSlot, URPGItem*>& GetSlottedItemMap() const = 0;
+	/** Returns the table of slots to items */
+	virtual const FRPGItemSlotTable& GetSlottedItemTable() const = 0;
 
 	/** Gets the delegate for inventory item changes */
 	virtual FOnInventoryItemChangedNative& GetInventoryItemChangedDelegate() = 0;
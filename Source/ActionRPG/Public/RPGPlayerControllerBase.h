@@ -15,16 +15,32 @@ class ACTIONRPG_API ARPGPlayerControllerBase : public APlayerController, public
 
 public:
 	// Constructor and overrides
-	ARPGPlayerControllerBase() {}
+	ARPGPlayerControllerBase()
+		: bAsyncLoadInventory(false)
+		, LastSaveEntriesWritten(0)
+		, InventoryTransactionDepth(0)
+		, bPendingInventorySave(false)
+		, bSaveAllInventory(true)
+		, InventoryLoadSerial(0)
+		, bInventoryLoadPending(false)
+	{}
 	virtual void BeginPlay() override;
 
 	/** Map of all items owned by this player, from definition to data */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Inventory)
 	TMap<URPGItem*, FRPGItemData> InventoryData;
 
-	/** Map of slot, from type/num to item, initialized from ItemSlotsPerType on RPGGameInstanceBase */
+	/** Table of slots, from type/num to item, initialized from ItemSlotsPerType on RPGGameInstanceBase. Use GetSlottedItem/GetSlottedItems from blueprints */
+	UPROPERTY(VisibleAnywhere, Category = Inventory)
+	FRPGItemSlotTable SlottedItems;
+
+	/** If true, LoadInventory streams all saved items in as one async batch and fills the inventory when it completes, instead of loading each item synchronously */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Inventory)
+	bool bAsyncLoadInventory;
+
+	/** Number of item and slot entries written to the save game by the last SaveInventory, a full rebuild writes all of them */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Inventory)
-	TMap<FRPGItemSlot, URPGItem*> SlottedItems;
+	int32 LastSaveEntriesWritten;
 
 	/** Delegate called when an inventory item has been added or removed */
 	UPROPERTY(BlueprintAssignable, Category = Inventory)
@@ -63,7 +79,7 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Inventory)
 	bool RemoveInventoryItem(URPGItem* RemovedItem, int32 RemoveCount = 1);
 
-	/** Returns all inventory items of a given type. If none is passed as type it will return all */
+	/** Returns all inventory items of a given type. If none is passed as type it will return all. Results are appended, so a reused array will not reallocate */
 	UFUNCTION(BlueprintCallable, Category = Inventory)
 	void GetInventoryItems(TArray<URPGItem*>& Items, FPrimaryAssetType ItemType);
 
@@ -83,7 +99,7 @@ public:
 	UFUNCTION(BlueprintPure, Category = Inventory)
 	URPGItem* GetSlottedItem(FRPGItemSlot ItemSlot) const;
 
-	/** Returns all slotted items of a given type. If none is passed as type it will return all */
+	/** Returns all slotted items of a given type, including empty slots. If none is passed as type it will return all */
 	UFUNCTION(BlueprintCallable, Category = Inventory)
 	void GetSlottedItems(TArray<URPGItem*>& Items, FPrimaryAssetType ItemType, bool bOutputEmptyIndexes);
 
@@ -91,20 +107,39 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Inventory)
 	void FillEmptySlots();
 
-	/** Manually save the inventory, this is called from add/remove functions automatically */
+	/** Manually save the inventory, this is called from add/remove functions automatically. Only entries changed since the last save are written */
 	UFUNCTION(BlueprintCallable, Category = Inventory)
 	bool SaveInventory();
 
-	/** Loads inventory from save game on game instance, this will replace arrays */
+	/** Loads inventory from save game on game instance, this will replace arrays. With bAsyncLoadInventory the arrays are filled in later and OnInventoryLoaded fires once they are */
 	UFUNCTION(BlueprintCallable, Category = Inventory)
 	bool LoadInventory();
 
+	/** Returns true if an async inventory load is still waiting on items. Adding, removing, slotting and saving fail until it completes */
+	UFUNCTION(BlueprintPure, Category = Inventory)
+	bool IsInventoryLoading() const;
+
+	/**
+	 * Starts an inventory transaction, use this when making many changes at once such as looting or selling
+	 * Until the matching commit, change notifications are merged and saving is deferred. Transactions can be nested
+	 */
+	UFUNCTION(BlueprintCallable, Category = Inventory)
+	void BeginInventoryTransaction();
+
+	/** Ends an inventory transaction. When the outermost one commits, each changed item and slot is notified once and the inventory is saved once */
+	UFUNCTION(BlueprintCallable, Category = Inventory)
+	void CommitInventoryTransaction();
+
+	/** Returns true if an inventory transaction is open */
+	UFUNCTION(BlueprintPure, Category = Inventory)
+	bool IsInInventoryTransaction() const;
+
 	// Implement IRPGInventoryInterface
 	virtual const TMap<URPGItem*, FRPGItemData>& GetInventoryDataMap() const override
 	{
 		return InventoryData;
 	}
-	virtual const TMap<FRPGItemSlot, URPGItem*>& GetSlottedItemMap() const override
+	virtual const FRPGItemSlotTable& GetSlottedItemTable() const override
 	{
 		return SlottedItems;
 	}
@@ -122,6 +157,61 @@ public:
 	}
 
 protected:
+	/** Secondary index of InventoryData, from item type to every item of that type. Kept in sync with InventoryData so type queries only touch matching items */
+	TMap<FPrimaryAssetType, TArray<URPGItem*>> InventoryItemsByType;
+
+	/** Item registry index of every item in InventoryData, resolved once when the item enters the inventory so later changes never read the item for it */
+	TMap<URPGItem*, int32> InventoryRegistryIndices;
+
+	/** Adds/removes an item from the type and registry indices, call whenever an item enters or leaves InventoryData */
+	void AddToInventoryTypeIndex(URPGItem* Item, int32 RegistryIndex);
+	void RemoveFromInventoryTypeIndex(URPGItem* Item);
+
+	/** Returns the stored registry index of an item in the inventory, or resolves it from the item if it is not in the inventory */
+	int32 GetInventoryRegistryIndex(URPGItem* Item) const;
+
+	/** Number of nested inventory transactions that are open */
+	int32 InventoryTransactionDepth;
+
+	/** Items changed during the current transaction, with the added flag of the last change */
+	UPROPERTY()
+	TMap<URPGItem*, bool> PendingItemChanges;
+
+	/** Slots changed during the current transaction, they are notified with whatever item is in them at commit */
+	TSet<FRPGItemSlot> PendingSlotChanges;
+
+	/** True if a save was requested during the current transaction */
+	bool bPendingInventorySave;
+
+	/** Items whose data changed since the last save, with the id they are saved under */
+	UPROPERTY()
+	TMap<URPGItem*, FPrimaryAssetId> DirtyItems;
+
+	/** Slots whose contents changed since the last save */
+	TSet<FRPGItemSlot> DirtySlots;
+
+	/** If true, the next save rebuilds the inventory in the save game from scratch */
+	bool bSaveAllInventory;
+
+	/** Save game the dirty entries are relative to, everything is written if the current save game changes */
+	TWeakObjectPtr<URPGSaveGame> LastSavedGame;
+
+	/** Records that an item or slot needs to be written on the next save */
+	void MarkInventoryItemDirty(URPGItem* Item);
+	void MarkSlotDirty(const FRPGItemSlot& ItemSlot);
+
+	/** Incremented by every LoadInventory, so async loads that were superseded can be ignored */
+	int32 InventoryLoadSerial;
+
+	/** True while an async inventory load is in flight */
+	bool bInventoryLoadPending;
+
+	/** Fills InventoryData and SlottedItems from a save game, items must be loadable */
+	void CopyInventoryFromSaveGame(URPGSaveGame* SaveGame);
+
+	/** Called when the async batch started by LoadInventory completes */
+	void HandleInventoryItemsLoaded(int32 LoadSerial);
+
 	/** Auto slots a specific item, returns true if anything changed */
 	bool FillEmptySlotWithItem(URPGItem* NewItem);
 
@@ -133,3 +223,27 @@ protected:
 	/** Called when a global save game as been loaded */
 	void HandleSaveGameLoaded(URPGSaveGame* NewSaveGame);
 };
+
+/** Keeps an inventory transaction open for the lifetime of this object, for native code that changes many items at once */
+struct FRPGInventoryTransactionScope
+{
+	explicit FRPGInventoryTransactionScope(ARPGPlayerControllerBase* InController)
+		: Controller(InController)
+	{
+		if (Controller)
+		{
+			Controller->BeginInventoryTransaction();
+		}
+	}
+
+	~FRPGInventoryTransactionScope()
+	{
+		if (Controller)
+		{
+			Controller->CommitInventoryTransaction();
+		}
+	}
+
+private:
+	ARPGPlayerControllerBase* Controller;
+};
@@ -18,6 +18,8 @@ namespace ERPGSaveGameVersion
 		AddedInventory,
 		// Added ItemData to store count/level
 		AddedItemData,
+		// Added optional compact inventory format
+		AddedCompactInventory,
 
 		// -----<new versions must be added before this line>-------------------------------------------------
 		VersionPlusOne,
@@ -25,6 +27,18 @@ namespace ERPGSaveGameVersion
 	};
 }
 
+/** How the inventory maps of a save game are stored in the archive */
+UENUM(BlueprintType)
+enum class ERPGSaveInventoryFormat : uint8
+{
+	/** Regular tagged properties, this is the largest but easiest to debug */
+	Tagged,
+	/** Asset ids interned into a string table, with packed counts and levels */
+	Compact,
+	/** Compact, then compressed */
+	CompactCompressed
+};
+
 /** Object that is written to and read from the save game archive, with a data version */
 UCLASS(BlueprintType)
 class ACTIONRPG_API URPGSaveGame : public USaveGame
@@ -37,6 +51,8 @@ public:
 	{
 		// Set to current version, this will get overwritten during serialization when loading
 		SavedDataVersion = ERPGSaveGameVersion::LatestVersion;
+		InventoryFormat = ERPGSaveInventoryFormat::Tagged;
+		JournalSequence = 0;
 	}
 
 	/** Map of items to item data */
@@ -51,6 +67,14 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = SaveGame)
 	FString UserId;
 
+	/** Format used for InventoryData and SlottedItems the next time this is saved. When loading this is set to the format that was read */
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = SaveGame)
+	ERPGSaveInventoryFormat InventoryFormat;
+
+	/** Sequence number of the last journal record included in this snapshot, newer records are replayed on top when loading */
+	UPROPERTY()
+	int64 JournalSequence;
+
 protected:
 	/** Deprecated way of storing items, this is read in but not saved out */
 	UPROPERTY()
@@ -62,4 +86,7 @@ protected:
 
 	/** Overridden to allow version fixups */
 	virtual void Serialize(FArchive& Ar) override;
+
+	/** Reads or writes the inventory maps in the compact format, after the tagged properties */
+	void SerializeCompactInventory(FArchive& Ar);
 };
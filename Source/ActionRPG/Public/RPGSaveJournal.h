@@ -0,0 +1,123 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ActionRPG.h"
+#include "Async/Future.h"
+
+class IFileHandle;
+class URPGSaveGame;
+
+/** A single inventory change stored in the save journal */
+struct ACTIONRPG_API FRPGSaveJournalRecord
+{
+	/** Kind of change this record describes */
+	enum class EType : uint8
+	{
+		/** Item was added or its count/level changed */
+		SetItem,
+		/** Item was removed from the inventory */
+		RemoveItem,
+		/** Slot contents changed, an invalid ItemId means the slot was emptied */
+		SetSlot
+	};
+
+	FRPGSaveJournalRecord()
+		: Sequence(0)
+		, Type(EType::SetItem)
+	{}
+
+	/** Increasing number assigned when the record is appended */
+	int64 Sequence;
+
+	/** Kind of change */
+	EType Type;
+
+	/** Item that changed, or the item now in the slot */
+	FPrimaryAssetId ItemId;
+
+	/** New data for SetItem records */
+	FRPGItemData ItemData;
+
+	/** Slot that changed for SetSlot records */
+	FRPGItemSlot ItemSlot;
+
+	/** Applies this change to the maps of a save game */
+	void Apply(URPGSaveGame* SaveGame) const;
+
+	friend FArchive& operator<<(FArchive& Ar, FRPGSaveJournalRecord& Record);
+};
+
+/**
+ * Append-only log of inventory changes for one save slot, stored next to the save game
+ * Every record is written and flushed on its own, so a crash loses at most the record being written
+ * Once a snapshot containing a sequence number is on disk, the records up to it are dropped from the file
+ * The file is rewritten on a worker thread and swapped in on the game thread by a later call, a rewrite left over by a crash is recovered when the journal is opened
+ */
+class ACTIONRPG_API FRPGSaveJournal
+{
+public:
+	FRPGSaveJournal();
+	~FRPGSaveJournal();
+
+	/** Points the journal at the file for a slot, closing any file that was open and recovering from a rewrite that was cut off */
+	void Open(const FString& SlotName, int32 UserIndex);
+
+	/** Closes the file, records already written stay on disk. Waits for a rewrite that is still running */
+	void Close();
+
+	/** Reads the journal from disk and applies every record newer than the snapshot in the save game. Returns the number applied */
+	int32 Replay(URPGSaveGame* SaveGame);
+
+	/** Assigns the next sequence number and appends a record. Returns false if it could not be written */
+	bool Append(FRPGSaveJournalRecord& Record);
+
+	/** Called once a snapshot with everything up to SnapshotSequence is on disk, starts rewriting the file with only the newer records */
+	void Compact(int64 SnapshotSequence);
+
+	/** Deletes every record, used when the save game is reset */
+	void Reset();
+
+	/** Returns the number of records that are not in a snapshot yet */
+	int32 Num() const
+	{
+		return PendingRecords.Num();
+	}
+
+	/** Returns the sequence number of the last record appended or replayed */
+	int64 GetLastSequence() const
+	{
+		return NextSequence - 1;
+	}
+
+private:
+	/** Full path of the journal file, empty if not open */
+	FString FilePath;
+
+	/** Append handle, opened on first write */
+	TUniquePtr<IFileHandle> FileHandle;
+
+	/** Records on disk that are not in a snapshot yet */
+	TArray<FRPGSaveJournalRecord> PendingRecords;
+
+	/** Sequence number for the next record */
+	int64 NextSequence;
+
+	/** Result of the rewrite running on a worker, invalid if there is none */
+	TFuture<bool> CompactionResult;
+
+	/** Last sequence given to the running rewrite, newer records are copied over when it is swapped in */
+	int64 CompactedSequence;
+
+	/** Returns the path the file is rewritten to */
+	FString GetTempFilePath() const;
+
+	/** Swaps in a finished rewrite, if bWait is true this blocks until a running one is done */
+	void FinishCompaction(bool bWait);
+
+	/** Writes a size and checksum prefixed record */
+	static bool WriteRecord(IFileHandle& Handle, FRPGSaveJournalRecord& Record);
+
+	/** Reads records from the file, stopping at the first one that is cut off or fails its checksum */
+	bool ReadRecords(TArray<FRPGSaveJournalRecord>& OutRecords) const;
+};
@@ -0,0 +1,186 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ActionRPG.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Async/Future.h"
+#include "RPGSaveService.generated.h"
+
+class URPGSaveGame;
+
+/** I/O statistics reported by the save service */
+USTRUCT(BlueprintType)
+struct ACTIONRPG_API FRPGSaveServiceStats
+{
+	GENERATED_BODY()
+
+	/** Constructor */
+	FRPGSaveServiceStats()
+		: QueueDepth(0)
+		, InFlight(0)
+		, ReadsCompleted(0)
+		, WritesCompleted(0)
+		, WritesCoalesced(0)
+		, Failures(0)
+		, AverageReadLatency(0.0f)
+		, MaxReadLatency(0.0f)
+		, AverageWriteLatency(0.0f)
+		, MaxWriteLatency(0.0f)
+	{}
+
+	/** Operations waiting for a worker */
+	UPROPERTY(BlueprintReadOnly, Category = Save)
+	int32 QueueDepth;
+
+	/** Operations running on a worker right now */
+	UPROPERTY(BlueprintReadOnly, Category = Save)
+	int32 InFlight;
+
+	/** Number of finished reads */
+	UPROPERTY(BlueprintReadOnly, Category = Save)
+	int32 ReadsCompleted;
+
+	/** Number of finished writes */
+	UPROPERTY(BlueprintReadOnly, Category = Save)
+	int32 WritesCompleted;
+
+	/** Write requests merged into a write for the same user that was still queued */
+	UPROPERTY(BlueprintReadOnly, Category = Save)
+	int32 WritesCoalesced;
+
+	/** Reads or writes the platform save system reported as failed */
+	UPROPERTY(BlueprintReadOnly, Category = Save)
+	int32 Failures;
+
+	/** Average seconds from a read being requested to its save game being ready */
+	UPROPERTY(BlueprintReadOnly, Category = Save)
+	float AverageReadLatency;
+
+	/** Longest read latency in seconds */
+	UPROPERTY(BlueprintReadOnly, Category = Save)
+	float MaxReadLatency;
+
+	/** Average seconds from a write being requested to it being on disk */
+	UPROPERTY(BlueprintReadOnly, Category = Save)
+	float AverageWriteLatency;
+
+	/** Longest write latency in seconds */
+	UPROPERTY(BlueprintReadOnly, Category = Save)
+	float MaxWriteLatency;
+};
+
+/**
+ * Owns one save game per connected user, for servers that persist many players in one process
+ * Reads and writes run on at most RPG.SaveService.MaxConcurrentOperations worker tasks, operations for the same user always run one at a time in request order
+ * Save games are serialized and deserialized on the game thread, only the platform save system calls run on workers
+ */
+UCLASS()
+class ACTIONRPG_API URPGSaveService : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Subsystem overrides
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Delegate called when a user's save game has been loaded or created, or with null if the read failed */
+	UPROPERTY(BlueprintAssignable, Category = Save)
+	FOnUserSaveGameLoaded OnUserSaveGameLoaded;
+
+	/** Native delegate for user save game load */
+	FOnUserSaveGameLoadedNative OnUserSaveGameLoadedNative;
+
+	/**
+	 * Queues a read of a user's save game, OnUserSaveGameLoaded is called once it is ready, with a new save game if none existed
+	 * If the slot exists but can't be read it is called with null, and the user has no save game so writes are rejected until a read succeeds
+	 */
+	UFUNCTION(BlueprintCallable, Category = Save)
+	void LoadUserSaveGame(const FString& UserId);
+
+	/** Returns the save game of a user, or null if it has not been loaded */
+	UFUNCTION(BlueprintCallable, Category = Save)
+	URPGSaveGame* GetUserSaveGame(const FString& UserId) const;
+
+	/** Queues a write of a user's save game. The save game is serialized when the write starts, so requests made while one is queued are merged */
+	UFUNCTION(BlueprintCallable, Category = Save)
+	bool WriteUserSaveGame(const FString& UserId);
+
+	/** Writes any changes and stops hosting a user, call when the player leaves */
+	UFUNCTION(BlueprintCallable, Category = Save)
+	void ReleaseUser(const FString& UserId);
+
+	/** Returns the current I/O statistics */
+	UFUNCTION(BlueprintPure, Category = Save)
+	FRPGSaveServiceStats GetStats() const;
+
+	/** Returns the slot name used for a user */
+	UFUNCTION(BlueprintPure, Category = Save)
+	FString GetUserSlotName(const FString& UserId) const;
+
+protected:
+	/** A single queued read or write */
+	struct FSaveOperation
+	{
+		/** True for a write, false for a read */
+		bool bWrite;
+
+		/** Real time the operation was requested */
+		double RequestTime;
+	};
+
+	/** Queue and worker state for one user */
+	struct FUserState
+	{
+		FUserState()
+			: bRunning(false)
+			, bReleased(false)
+		{}
+
+		/** Operations in request order, the first one is running if bRunning is set */
+		TArray<FSaveOperation> Operations;
+
+		/** True while the first operation is on a worker */
+		bool bRunning;
+
+		/** True if the user left, the state is removed once the queue drains */
+		bool bReleased;
+
+		/** Worker task for the running operation */
+		TFuture<void> Task;
+	};
+
+	/** Save games of the hosted users */
+	UPROPERTY()
+	TMap<FString, URPGSaveGame*> UserSaveGames;
+
+	/** I/O state for every user with hosted data or queued operations */
+	TMap<FString, FUserState> UserStates;
+
+	/** Users that have a queued operation that is not running, in the order they became ready */
+	TArray<FString> ReadyUsers;
+
+	/** Number of operations on workers */
+	int32 RunningOperations;
+
+	/** Running totals, latencies are summed so averages can be reported */
+	FRPGSaveServiceStats Stats;
+	double TotalReadLatency;
+	double TotalWriteLatency;
+
+	/** Adds an operation to a user's queue and starts it if possible */
+	void QueueOperation(const FString& UserId, bool bWrite);
+
+	/** Starts the next operations of ready users while there are free workers */
+	void DispatchOperations();
+
+	/** Starts the first operation of a user on a worker */
+	void StartOperation(const FString& UserId, FUserState& State);
+
+	/** Called on the game thread when a worker has finished */
+	void HandleOperationFinished(const FString& UserId, bool bSuccess, const TArray<uint8>& LoadedData);
+
+	/** Creates the save game of a user after a read, from the read data or new if the slot did not exist. A failed read creates nothing */
+	void HandleUserRead(const FString& UserId, bool bSuccess, const TArray<uint8>& LoadedData);
+};
@@ -14,6 +14,36 @@
 class URPGItem;
 class URPGSaveGame;
 
+/** Item types known to native code, each one matches one of the item types on URPGAssetManager */
+enum class ERPGItemType : uint8
+{
+	/** Not a native type, code has to compare the FPrimaryAssetType instead */
+	Unknown,
+	Potion,
+	Skill,
+	Token,
+	Weapon,
+
+	Count
+};
+
+/** Compile time table between ERPGItemType and primary asset type names */
+namespace RPGItemTypes
+{
+	/** Primary asset type name of each native type, indexed by ERPGItemType */
+	constexpr const TCHAR* Names[] = { TEXT(""), TEXT("Potion"), TEXT("Skill"), TEXT("Token"), TEXT("Weapon") };
+	static_assert(UE_ARRAY_COUNT(Names) == (int32)ERPGItemType::Count, "Names must have an entry for every ERPGItemType");
+
+	/** Returns the primary asset type name of a native type */
+	constexpr const TCHAR* GetName(ERPGItemType ItemType)
+	{
+		return Names[(int32)ItemType];
+	}
+
+	/** Returns the native type for a primary asset type, or Unknown */
+	ACTIONRPG_API ERPGItemType FromAssetType(const FPrimaryAssetType& ItemType);
+}
+
 /** Struct representing a slot for an item, shown in the UI */
 USTRUCT(BlueprintType)
 struct ACTIONRPG_API FRPGItemSlot
@@ -23,11 +53,20 @@ struct ACTIONRPG_API FRPGItemSlot
 	/** Constructor, -1 means an invalid slot */
 	FRPGItemSlot()
 		: SlotNumber(-1)
+		, NativeType(ERPGItemType::Unknown)
 	{}
 
 	FRPGItemSlot(const FPrimaryAssetType& InItemType, int32 InSlotNumber)
 		: ItemType(InItemType)
 		, SlotNumber(InSlotNumber)
+		, NativeType(RPGItemTypes::FromAssetType(InItemType))
+	{}
+
+	/** Constructor for when the native type of InItemType is already known */
+	FRPGItemSlot(const FPrimaryAssetType& InItemType, ERPGItemType InNativeType, int32 InSlotNumber)
+		: ItemType(InItemType)
+		, SlotNumber(InSlotNumber)
+		, NativeType(InNativeType)
 	{}
 
 	/** The type of items that can go in this slot */
@@ -38,9 +77,28 @@ struct ACTIONRPG_API FRPGItemSlot
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Item)
 	int32 SlotNumber;
 
-	/** Equality operators */
+	/** Native version of ItemType. Blueprints can only set ItemType, so this is refreshed on load and where slots come in from blueprints */
+	ERPGItemType NativeType;
+
+	/** Sets NativeType from ItemType */
+	void RefreshNativeType()
+	{
+		NativeType = RPGItemTypes::FromAssetType(ItemType);
+	}
+
+	/** Type and slot packed into one integer, only unique for native types */
+	uint64 GetPackedKey() const
+	{
+		return ((uint64)NativeType << 32) | (uint32)SlotNumber;
+	}
+
+	/** Equality operators, native types compare as one integer */
 	bool operator==(const FRPGItemSlot& Other) const
 	{
+		if (NativeType != ERPGItemType::Unknown && Other.NativeType != ERPGItemType::Unknown)
+		{
+			return GetPackedKey() == Other.GetPackedKey();
+		}
 		return ItemType == Other.ItemType && SlotNumber == Other.SlotNumber;
 	}
 	bool operator!=(const FRPGItemSlot& Other) const
@@ -51,11 +109,14 @@ struct ACTIONRPG_API FRPGItemSlot
 	/** Implemented so it can be used in Maps/Sets */
 	friend inline uint32 GetTypeHash(const FRPGItemSlot& Key)
 	{
-		uint32 Hash = 0;
+		// Resolve the type if it was not refreshed, so equal slots always hash the same
+		const ERPGItemType NativeType = Key.NativeType != ERPGItemType::Unknown ? Key.NativeType : RPGItemTypes::FromAssetType(Key.ItemType);
 
-		Hash = HashCombine(Hash, GetTypeHash(Key.ItemType));
-		Hash = HashCombine(Hash, (uint32)Key.SlotNumber);
-		return Hash;
+		if (NativeType != ERPGItemType::Unknown)
+		{
+			return GetTypeHash(FRPGItemSlot(Key.ItemType, NativeType, Key.SlotNumber).GetPackedKey());
+		}
+		return HashCombine(GetTypeHash(Key.ItemType), (uint32)Key.SlotNumber);
 	}
 
 	/** Returns true if slot is valid */
@@ -63,6 +124,24 @@ struct ACTIONRPG_API FRPGItemSlot
 	{
 		return ItemType.IsValid() && SlotNumber >= 0;
 	}
+
+	/** Refreshes NativeType after loading */
+	void PostSerialize(const FArchive& Ar)
+	{
+		if (Ar.IsLoading())
+		{
+			RefreshNativeType();
+		}
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FRPGItemSlot> : public TStructOpsTypeTraitsBase2<FRPGItemSlot>
+{
+	enum
+	{
+		WithPostSerialize = true,
+	};
 };
 
 
@@ -125,6 +204,110 @@ struct ACTIONRPG_API FRPGItemData
 	}
 };
 
+/** Dense storage for all the slots of one item type, indexed by slot number */
+USTRUCT()
+struct ACTIONRPG_API FRPGItemSlotArray
+{
+	GENERATED_BODY()
+
+	/** Item in each slot, null if the slot is empty */
+	UPROPERTY(VisibleAnywhere, Category = Item)
+	TArray<URPGItem*> Items;
+
+	/** Item registry index of each slot, INDEX_NONE if the slot is empty. Kept next to Items so hot paths never read the item itself */
+	TArray<int32> RegistryIndices;
+
+	/** One bit per slot, set if that slot is empty */
+	TBitArray<> FreeSlots;
+
+	/** Native type of the slots, so slots can be built without looking it up */
+	ERPGItemType NativeType = ERPGItemType::Unknown;
+};
+
+/**
+ * Fixed table of item slots, built from ItemSlotsPerType on RPGGameInstanceBase
+ * Each type owns a contiguous array with a free slot bitmask, and a reverse map tracks which slot an item is in
+ * An item can only be in one slot at a time, so slotting, unslotting and auto slotting never have to search
+ */
+USTRUCT()
+struct ACTIONRPG_API FRPGItemSlotTable
+{
+	GENERATED_BODY()
+
+	/** Clears the table and creates empty slots for every type */
+	void Initialize(const TMap<FPrimaryAssetType, int32>& SlotsPerType);
+
+	/** Removes all slots */
+	void Reset();
+
+	/** Returns true if this slot exists in the table */
+	bool IsValidSlot(const FRPGItemSlot& ItemSlot) const;
+
+	/** Returns item in slot, or null if empty or invalid */
+	URPGItem* GetItem(const FRPGItemSlot& ItemSlot) const;
+
+	/** Returns the item registry index of the item in a slot, or INDEX_NONE if empty or invalid */
+	int32 GetRegistryIndex(const FRPGItemSlot& ItemSlot) const;
+
+	/**
+	 * Puts an item in a slot, removing it from any other slot. Passing null empties the slot. Returns false if the slot does not exist
+	 * RegistryIndex is stored with the item, if it is INDEX_NONE it is read from the item
+	 */
+	bool SetItem(const FRPGItemSlot& ItemSlot, URPGItem* Item, int32 RegistryIndex = INDEX_NONE);
+
+	/** Returns the slot this item is in, or an invalid slot if it is not slotted */
+	FRPGItemSlot FindItemSlot(const URPGItem* Item) const;
+
+	/** Returns the lowest numbered empty slot for this type, or an invalid slot if they are all full */
+	FRPGItemSlot FindFreeSlot(const FPrimaryAssetType& ItemType) const;
+
+	/** Returns the slot array for a type, or null if the type has no slots */
+	const FRPGItemSlotArray* FindSlotArray(const FPrimaryAssetType& ItemType) const
+	{
+		return SlotsByType.Find(ItemType);
+	}
+
+	/** Returns the total number of slots across all types */
+	int32 Num() const;
+
+	/** Calls Func(ItemSlot, Item) for every slot, in type order and then slot order */
+	template<typename FuncType>
+	void ForEachSlot(FuncType&& Func) const
+	{
+		for (const TPair<FPrimaryAssetType, FRPGItemSlotArray>& Pair : SlotsByType)
+		{
+			for (int32 SlotNumber = 0; SlotNumber < Pair.Value.Items.Num(); SlotNumber++)
+			{
+				Func(FRPGItemSlot(Pair.Key, Pair.Value.NativeType, SlotNumber), Pair.Value.Items[SlotNumber]);
+			}
+		}
+	}
+
+	/** Calls Func(ItemSlot, Item, RegistryIndex) for every slot, in the same order as ForEachSlot */
+	template<typename FuncType>
+	void ForEachSlotWithRegistryIndex(FuncType&& Func) const
+	{
+		for (const TPair<FPrimaryAssetType, FRPGItemSlotArray>& Pair : SlotsByType)
+		{
+			for (int32 SlotNumber = 0; SlotNumber < Pair.Value.Items.Num(); SlotNumber++)
+			{
+				Func(FRPGItemSlot(Pair.Key, Pair.Value.NativeType, SlotNumber), Pair.Value.Items[SlotNumber], Pair.Value.RegistryIndices[SlotNumber]);
+			}
+		}
+	}
+
+protected:
+	/** Slot arrays for each type, in the order they were initialized */
+	UPROPERTY(VisibleAnywhere, Category = Item)
+	TMap<FPrimaryAssetType, FRPGItemSlotArray> SlotsByType;
+
+	/** Reverse map from item to the slot it is in */
+	TMap<URPGItem*, FRPGItemSlot> ItemToSlot;
+
+	/** Writes a single slot entry without touching the reverse map */
+	void WriteSlot(FRPGItemSlotArray& SlotArray, int32 SlotNumber, URPGItem* Item, int32 RegistryIndex);
+};
+
 /** Delegate called when an inventory item changes */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnInventoryItemChanged, bool, bAdded, URPGItem*, Item);
 DECLARE_MULTICAST_DELEGATE_TwoParams(FOnInventoryItemChangedNative, bool, URPGItem*);
@@ -140,3 +323,7 @@ DECLARE_MULTICAST_DELEGATE(FOnInventoryLoadedNative);
 /** Delegate called when the save game has been loaded/reset */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSaveGameLoaded, URPGSaveGame*, SaveGame);
 DECLARE_MULTICAST_DELEGATE_OneParam(FOnSaveGameLoadedNative, URPGSaveGame*);
+
+/** Delegate called when the save game of a user hosted by the save service has been loaded or created */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnUserSaveGameLoaded, const FString&, UserId, URPGSaveGame*, SaveGame);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnUserSaveGameLoadedNative, const FString&, URPGSaveGame*);
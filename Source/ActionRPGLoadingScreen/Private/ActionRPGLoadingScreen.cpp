@@ -5,6 +5,11 @@
 #include "SlateExtras.h"
 #include "MoviePlayer.h"
 #include "Widgets/Images/SThrobber.h"
+#include "Widgets/Notifications/SProgressBar.h"
+#include <atomic>
+
+/** Progress shown on the loading screen, the widget reads this from the loading screen thread */
+static std::atomic<float> GRPGLoadingProgress(-1.0f);
 
 
 
@@ -69,8 +74,28 @@ public:
 				.HAlign(HAlign_Right)
 				.Padding(FMargin(10.0f))
 				[
-					SNew(SThrobber)
+					SNew(SHorizontalBox)
 					.Visibility(this, &SRPGLoadingScreen::GetLoadIndicatorVisibility)
+					+SHorizontalBox::Slot()
+					.AutoWidth()
+					.VAlign(VAlign_Center)
+					.Padding(FMargin(0.0f, 0.0f, 10.0f, 0.0f))
+					[
+						SNew(SBox)
+						.WidthOverride(200.0f)
+						.HeightOverride(8.0f)
+						.Visibility(this, &SRPGLoadingScreen::GetProgressVisibility)
+						[
+							SNew(SProgressBar)
+							.Percent(this, &SRPGLoadingScreen::GetProgress)
+						]
+					]
+					+SHorizontalBox::Slot()
+					.AutoWidth()
+					.VAlign(VAlign_Center)
+					[
+						SNew(SThrobber)
+					]
 				]
 			]
 		];
@@ -84,6 +109,18 @@ private:
 		return GetMoviePlayer()->IsLoadingFinished() ? EVisibility::Collapsed : EVisibility::Visible;
 	}
 	
+	/** Rather to show the progress bar, it is hidden until something reports progress */
+	EVisibility GetProgressVisibility() const
+	{
+		return GRPGLoadingProgress.load(std::memory_order_relaxed) >= 0.0f ? EVisibility::Visible : EVisibility::Collapsed;
+	}
+
+	/** Current progress for the progress bar */
+	TOptional<float> GetProgress() const
+	{
+		return FMath::Clamp(GRPGLoadingProgress.load(std::memory_order_relaxed), 0.0f, 1.0f);
+	}
+
 	/** Loading screen image brush */
 	TSharedPtr<FSlateDynamicImageBrush> LoadingScreenBrush;
 };
@@ -116,6 +153,9 @@ public:
 		LoadingScreen.MinimumLoadingScreenDisplayTime = PlayTime;
 		LoadingScreen.WidgetLoadingScreen = SNew(SRPGLoadingScreen);
 		GetMoviePlayer()->SetupLoadingScreen(LoadingScreen);
+
+		// Progress belongs to whatever set it last, a new screen starts without a bar until someone reports again
+		GRPGLoadingProgress.store(-1.0f, std::memory_order_relaxed);
 	}
 
 	virtual void StopInGameLoadingScreen() override
@@ -123,6 +163,16 @@ public:
 		GetMoviePlayer()->StopMovie();
 	}
 
+	virtual void SetLoadingProgress(float Progress) override
+	{
+		GRPGLoadingProgress.store(Progress, std::memory_order_relaxed);
+	}
+
+	virtual float GetLoadingProgress() const override
+	{
+		return GRPGLoadingProgress.load(std::memory_order_relaxed);
+	}
+
 	virtual void CreateScreen()
 	{
 		FLoadingScreenAttributes LoadingScreen;
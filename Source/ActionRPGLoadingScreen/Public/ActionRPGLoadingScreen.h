@@ -20,4 +20,10 @@ public:
 
 	/** Stops the loading screen */
 	virtual void StopInGameLoadingScreen() = 0;
+
+	/** Sets the progress shown next to the throbber, from 0 to 1. A negative value hides the progress bar. Safe to call from any thread */
+	virtual void SetLoadingProgress(float Progress) = 0;
+
+	/** Returns the progress set by SetLoadingProgress */
+	virtual float GetLoadingProgress() const = 0;
 };